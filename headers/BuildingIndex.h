@@ -0,0 +1,145 @@
+#pragma once
+
+#include "ECS.h"
+#include "Components.h"
+#include "GridSystem.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+//every building standing on the grid, for nearest-target queries. membership follows the grid's occupancy events
+//(a building is in while it covers at least one tile), so nothing is rescanned per tick. positions go into a 2-d tree
+//over the XZ plane that is rebuilt only when the set changed, which is rare next to how often enemies ask
+class BuildingIndex {
+public:
+    struct Nearest {
+        ecs::Entity entity = ecs::NULL_ENTITY;
+        float distance = FLT_MAX;
+    };
+
+    void Clear() {
+        m_TileCounts.clear();
+        m_Tree.clear();
+        m_Dirty = false;
+        m_SeenVersion = 0;
+    }
+
+    //catches up with the grid. anything that isn't a building (maze walls, test obstacles) is ignored
+    void Sync(const GridSystem& grid, ecs::Registry& registry) {
+        uint32_t version = grid.GetOccupancyVersion();
+        if (version == m_SeenVersion) return;
+
+        bool upToDate = grid.ForEachOccupancyChangeSince(m_SeenVersion, [&](const OccupancyChange& change) {
+            if (change.occupied) {
+                if (!registry.IsAlive(change.entity) || !registry.HasComponent<BuildingComponent>(change.entity)) return;
+                if (m_TileCounts[change.entity]++ == 0) m_Dirty = true;
+            }
+            else {
+                auto it = m_TileCounts.find(change.entity);
+                if (it == m_TileCounts.end()) return;
+                if (--it->second == 0) {
+                    m_TileCounts.erase(it);
+                    m_Dirty = true;
+                }
+            }
+        });
+        if (!upToDate) Rescan(grid, registry);
+        m_SeenVersion = version;
+
+        if (m_Dirty) Rebuild(registry);
+    }
+
+    bool Empty() const { return m_Tree.empty(); }
+    size_t Size() const { return m_Tree.size(); }
+    size_t GetRebuilds() const { return m_Rebuilds; }
+
+    //closest building center on the XZ plane, O(log n) on average
+    Nearest FindNearest(const glm::vec3& position) const {
+        Nearest best;
+        if (m_Tree.empty()) return best;
+        float bestSq = FLT_MAX;
+        Search(0, m_Tree.size(), 0, glm::vec2(position.x, position.z), best.entity, bestSq);
+        best.distance = std::sqrt(bestSq);
+        return best;
+    }
+
+    size_t GetMemoryUsage() const {
+        return m_Tree.capacity() * sizeof(Node) + m_TileCounts.size() * (sizeof(ecs::Entity) + sizeof(int) + sizeof(void*));
+    }
+
+private:
+    struct Node {
+        glm::vec2 position;
+        ecs::Entity entity;
+    };
+
+    std::unordered_map<ecs::Entity, int> m_TileCounts; //building -> tiles it covers
+    std::vector<Node> m_Tree; //implicit tree: the median of a range is its root, children are the halves beside it
+    uint32_t m_SeenVersion = 0;
+    bool m_Dirty = false;
+    size_t m_Rebuilds = 0;
+
+    void Rescan(const GridSystem& grid, ecs::Registry& registry) {
+        m_TileCounts.clear();
+        for (int y = 0; y < grid.GetHeight(); ++y) {
+            for (int x = 0; x < grid.GetWidth(); ++x) {
+                ecs::Entity entity = grid.GetEntityAt(x, y);
+                if (entity == ecs::NULL_ENTITY || !registry.IsAlive(entity) || !registry.HasComponent<BuildingComponent>(entity)) continue;
+                ++m_TileCounts[entity];
+            }
+        }
+        m_Dirty = true;
+    }
+
+    void Rebuild(ecs::Registry& registry) {
+        m_Tree.clear();
+        for (auto it = m_TileCounts.begin(); it != m_TileCounts.end();) {
+            if (!registry.IsAlive(it->first)) { //destroyed without its tiles being freed, e.g. by a registry reset
+                it = m_TileCounts.erase(it);
+                continue;
+            }
+            glm::vec3 position = registry.GetComponent<TransformComponent>(it->first).position;
+            m_Tree.push_back({ { position.x, position.z }, it->first });
+            ++it;
+        }
+        Build(0, m_Tree.size(), 0);
+        m_Dirty = false;
+        ++m_Rebuilds;
+    }
+
+    void Build(size_t begin, size_t end, int axis) {
+        if (end - begin <= 1) return;
+        size_t mid = begin + (end - begin) / 2;
+        std::nth_element(m_Tree.begin() + begin, m_Tree.begin() + mid, m_Tree.begin() + end, [axis](const Node& a, const Node& b) {
+            return a.position[axis] < b.position[axis];
+        });
+        Build(begin, mid, axis ^ 1);
+        Build(mid + 1, end, axis ^ 1);
+    }
+
+    void Search(size_t begin, size_t end, int axis, glm::vec2 point, ecs::Entity& bestEntity, float& bestSq) const {
+        if (begin >= end) return;
+        size_t mid = begin + (end - begin) / 2;
+        const Node& node = m_Tree[mid];
+        glm::vec2 offset = point - node.position;
+        float distanceSq = glm::dot(offset, offset);
+        if (distanceSq < bestSq) {
+            bestSq = distanceSq;
+            bestEntity = node.entity;
+        }
+
+        //the near half first, the far half only if the splitting line is closer than the best so far
+        float split = offset[axis];
+        bool nearIsLow = split < 0.0f;
+        if (nearIsLow) Search(begin, mid, axis ^ 1, point, bestEntity, bestSq);
+        else Search(mid + 1, end, axis ^ 1, point, bestEntity, bestSq);
+        if (split * split < bestSq) {
+            if (nearIsLow) Search(mid + 1, end, axis ^ 1, point, bestEntity, bestSq);
+            else Search(begin, mid, axis ^ 1, point, bestEntity, bestSq);
+        }
+    }
+};
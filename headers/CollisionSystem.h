@@ -3,55 +3,109 @@
 
 #include "ECS.h"
 #include "Components.h"
+#include "GridSystem.h"
+#include "Scheduler.h"
+#include "SpatialHashSystem.h"
 #include <glm/glm.hpp>
 #include <vector>
+#include <cmath>
 
 class CollisionSystem : public ecs::System {
 public:
+    void Init(SpatialHashSystem* spatial) {
+        m_Spatial = spatial;
+    }
+
+    //enemy vs enemy goes through the spatial hash; buildings cover whole tiles, so enemy vs building only has to
+    //look at the 3x3 tiles around the enemy
     void Update(float dt, GridSystem* gridSystem) {
-        std::vector<ecs::Entity> collidables(m_Entities.begin(), m_Entities.end());
+        m_Registry->View<EnemyComponent, TransformComponent, CollisionComponent>().Each([&](ecs::Entity entityA, EnemyComponent&, TransformComponent& transformA, CollisionComponent& collisionA) {
+            float reach = collisionA.radius + m_Spatial->GetMaxEnemyRadius() + SpatialHashSystem::MOVEMENT_SLACK;
+            m_Spatial->GetEnemies().QueryRadius(transformA.position, reach, [&](ecs::Entity entityB, const glm::vec3&) {
+                PushApart(gridSystem, entityA, transformA, collisionA, entityB);
+            });
+            PushOutOfObstacle(gridSystem, transformA, collisionA);
+        });
+    }
 
-        for (size_t i = 0; i < collidables.size(); ++i) {
-            auto entityA = collidables[i];
-            if (!m_Registry->HasComponent<EnemyComponent>(entityA)) continue;
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess()
+            .Read<EnemyComponent, CollisionComponent>()
+            .Write<TransformComponent>()
+            .ReadResource<GridSystem, SpatialHashSystem>();
+    }
 
-            auto& transformA = m_Registry->GetComponent<TransformComponent>(entityA);
-            auto& collisionA = m_Registry->GetComponent<CollisionComponent>(entityA);
+private:
+    SpatialHashSystem* m_Spatial = nullptr;
 
-            for (size_t j = 0; j < collidables.size(); ++j) {
-                if (i == j) continue; 
+    void PushApart(GridSystem* gridSystem, ecs::Entity entityA, TransformComponent& transformA, const CollisionComponent& collisionA, ecs::Entity entityB) {
+        if (entityA == entityB) return;
+        if (!m_Registry->HasComponent<CollisionComponent>(entityB)) return;
 
-                auto entityB = collidables[j];
-                auto& transformB = m_Registry->GetComponent<TransformComponent>(entityB);
-                auto& collisionB = m_Registry->GetComponent<CollisionComponent>(entityB);
+        auto& transformB = m_Registry->GetComponent<TransformComponent>(entityB);
+        auto& collisionB = m_Registry->GetComponent<CollisionComponent>(entityB);
 
-                glm::vec2 posA = { transformA.position.x, transformA.position.z };
-                glm::vec2 posB = { transformB.position.x, transformB.position.z };
-                float dist = glm::distance(posA, posB);
+        glm::vec2 posA = { transformA.position.x, transformA.position.z };
+        glm::vec2 posB = { transformB.position.x, transformB.position.z };
+        float dist = glm::distance(posA, posB);
 
-                float radiusA = collisionA.radius;
-                float radiusB = collisionB.radius;
+        float combinedRadius = collisionA.radius + collisionB.radius;
 
-                if (m_Registry->HasComponent<BuildingComponent>(entityB)) {
-                    radiusB = (transformB.scale.x + transformB.scale.z) / 4.0f;
-                }
+        if (dist < combinedRadius) {
+            float overlap = combinedRadius - dist;
+            glm::vec2 pushDir = (dist > 0.001f) ? glm::normalize(posA - posB) : glm::vec2(1, 0);
 
-                float combinedRadius = radiusA + radiusB;
+            TryMove(gridSystem, transformA, pushDir * overlap);
+        }
+    }
 
-                if (dist < combinedRadius) {
-                    float overlap = combinedRadius - dist;
-                    glm::vec2 pushDir = (dist > 0.001f) ? glm::normalize(posA - posB) : glm::vec2(1, 0);
+    //an enemy (radius up to half a tile) can only overlap the tiles next to its own, so it is pushed out of every
+    //occupied one of those. a single nearest tile is not enough in corners and corridors, where two buildings
+    //touch it at once
+    void PushOutOfObstacle(GridSystem* gridSystem, TransformComponent& transform, const CollisionComponent& collision) {
+        glm::ivec2 tile = gridSystem->WorldToGrid(transform.position);
+        for (int y = tile.y - 1; y <= tile.y + 1; ++y) {
+            for (int x = tile.x - 1; x <= tile.x + 1; ++x) {
+                if (gridSystem->IsValidTile(x, y) && gridSystem->IsTileOccupied(x, y)) {
+                    PushOutOfTile(gridSystem, transform, collision, { x, y });
+                }
+            }
+        }
+    }
 
-                    glm::vec2 push = pushDir * overlap;
+    void PushOutOfTile(GridSystem* gridSystem, TransformComponent& transform, const CollisionComponent& collision, glm::ivec2 tile) {
+        glm::vec3 center3D = gridSystem->GridToWorld(tile.x, tile.y);
+        glm::vec2 center = { center3D.x, center3D.z };
+        glm::vec2 pos = { transform.position.x, transform.position.z };
+        glm::vec2 closest = glm::clamp(pos, center - 0.5f, center + 0.5f);
+        glm::vec2 offset = pos - closest;
+        float dist = glm::length(offset);
 
-                    glm::vec3 newPos = transformA.position + glm::vec3(push.x, 0.0f, push.y);
-                    glm::ivec2 newGridPos = gridSystem->WorldToGrid(newPos);
+        if (dist >= collision.radius) return;
 
-                    if (gridSystem->IsWalkable(newGridPos.x, newGridPos.y)) {
-                        transformA.position = newPos;
-                    }
-                }
+        if (dist > 0.001f) {
+            TryMove(gridSystem, transform, offset / dist * (collision.radius - dist));
+        }
+        else {
+            //standing inside the tile, leave through the nearest edge
+            glm::vec2 fromCenter = pos - center;
+            glm::vec2 push(0.0f);
+            if (std::abs(fromCenter.x) > std::abs(fromCenter.y)) {
+                push.x = (fromCenter.x >= 0.0f ? 1.0f : -1.0f) * (0.5f + collision.radius) - fromCenter.x;
+            }
+            else {
+                push.y = (fromCenter.y >= 0.0f ? 1.0f : -1.0f) * (0.5f + collision.radius) - fromCenter.y;
             }
+            TryMove(gridSystem, transform, push);
+        }
+    }
+
+    void TryMove(GridSystem* gridSystem, TransformComponent& transform, glm::vec2 push) {
+        glm::vec3 newPos = transform.position + glm::vec3(push.x, 0.0f, push.y);
+        glm::ivec2 newGridPos = gridSystem->WorldToGrid(newPos);
+
+        if (gridSystem->IsWalkable(newGridPos.x, newGridPos.y)) {
+            transform.position = newPos;
         }
     }
 };
\ No newline at end of file
@@ -6,97 +6,159 @@
 #include "BalanceSystem.h"
 #include "ResourceSystem.h"
 #include "GridSystem.h"
+#include "Prefabs.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "SpatialHashSystem.h"
 #include <iostream>
 #include <optional>
 #include <algorithm>
-#include <set> 
+#include <mutex>
 
 class CombatSystem : public ecs::System {
 public:
-    void Init(BalanceSystem* balance, ResourceSystem* resources, GridSystem* grid) {
+    void Init(BalanceSystem* balance, ResourceSystem* resources, GridSystem* grid, JobSystem* jobs, SpatialHashSystem* spatial) {
         m_BalanceSystem = balance;
         m_ResourceSystem = resources;
         m_GridSystem = grid;
+        m_Jobs = jobs;
+        m_Spatial = spatial;
     }
 
-    void Update(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies, const std::set<ecs::Entity>& allRenderableEntities) {
+    void Update(float dt, ecs::Registry* registry) {
 
 
-        UpdateTurrets(dt, registry, allEnemies);
+        UpdateTurrets(dt, registry);
 
-        UpdateEnemies(dt, registry, allEnemies);
-        UpdateBombs(dt, registry, allEnemies, allRenderableEntities);
-        CheckForDeaths(registry, allRenderableEntities);
+        UpdateEnemies(dt, registry);
+        UpdateBombs(registry);
+        CheckForDeaths(registry);
+    }
+
+    //damages everything with health within radius of center (enemies and buildings, found through the spatial hashes).
+    //returns the entities this blow took from alive to dead, the caller decides when their deaths are handled
+    std::vector<ecs::Entity> ApplyRadialDamage(glm::vec3 center, float radius, int damage) {
+        std::vector<ecs::Entity> killed;
+        auto damageTarget = [&](ecs::Entity target, const glm::vec3&) {
+            if (!m_Registry->HasComponent<HealthComponent>(target)) return;
+            auto& targetT = m_Registry->GetComponent<TransformComponent>(target);
+            if (glm::distance(center, targetT.position) >= radius) return;
+
+            auto& health = m_Registry->GetComponent<HealthComponent>(target);
+            bool wasAlive = health.currentHP > 0;
+            health.currentHP -= damage;
+            if (wasAlive && health.currentHP <= 0) {
+                killed.push_back(target);
+            }
+        };
+        m_Spatial->GetEnemies().QueryRadius(center, radius, damageTarget);
+        m_Spatial->GetBuildings().QueryRadius(center, radius, damageTarget);
+        return killed;
+    }
+
+    //deaths clear grid tiles and pay out through the balance/resource systems
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess()
+            .Read<EnemyComponent, BuildingComponent, BombComponent>()
+            .Write<TurretAIComponent, TransformComponent, HealthComponent, MovementComponent>()
+            .ReadResource<SpatialHashSystem>()
+            .WriteResource<GridSystem, BalanceSystem, ResourceSystem>();
     }
 
 private:
     BalanceSystem* m_BalanceSystem;
     ResourceSystem* m_ResourceSystem;
     GridSystem* m_GridSystem;
+    JobSystem* m_Jobs = nullptr;
+    SpatialHashSystem* m_Spatial = nullptr;
+
+    struct Shot {
+        ecs::Entity turret;
+        glm::vec3 from, to;
+    };
+
+    //targeting only reads enemies and writes the turret's own components, so turrets are spread across workers.
+    //shots are gathered and spawned afterwards in turret order, the command buffer is not thread safe
+    void UpdateTurrets(float dt, ecs::Registry* registry) {
+        auto turrets = registry->View<TurretAIComponent, TransformComponent>();
+        std::vector<Shot> shots;
+        std::mutex shotsMutex;
+
+        m_Jobs->ParallelFor(turrets.SizeHint(), [&](size_t begin, size_t end) {
+            std::vector<Shot> chunkShots;
+            turrets.EachInRange(begin, end, [&](ecs::Entity entity, TurretAIComponent& turret, TransformComponent& transform) {
+                UpdateTurret(dt, registry, entity, turret, transform, chunkShots);
+            });
+            if (chunkShots.empty()) return;
+            std::lock_guard<std::mutex> lock(shotsMutex);
+            shots.insert(shots.end(), chunkShots.begin(), chunkShots.end());
+        }, 64);
+
+        std::sort(shots.begin(), shots.end(), [](const Shot& a, const Shot& b) { return a.turret < b.turret; });
+        for (auto const& shot : shots) {
+            FireAtTarget(shot.from, shot.to);
+        }
+    }
 
-    void UpdateTurrets(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies) {
-        for (auto const& entity : m_Entities) {
-            auto& turret = m_Registry->GetComponent<TurretAIComponent>(entity);
-            auto& transform = m_Registry->GetComponent<TransformComponent>(entity);
-            turret.fireCooldown -= dt;
+    void UpdateTurret(float dt, ecs::Registry* registry, ecs::Entity entity, TurretAIComponent& turret, TransformComponent& transform, std::vector<Shot>& shots) {
+        turret.fireCooldown -= dt;
 
-            FindTargetForTurret(registry, allEnemies, entity);
+        FindTargetForTurret(registry, turret, transform);
 
-            if (IsTargetValid(registry, turret.currentTarget, transform, turret.range)) {
-                auto& targetTransform = registry->GetComponent<TransformComponent>(turret.currentTarget);
+        if (IsTargetValid(registry, turret.currentTarget, transform, turret.range)) {
+            auto& targetTransform = registry->GetComponent<TransformComponent>(turret.currentTarget);
 
-                float aimDifference = RotateTurret(transform, turret, targetTransform.position, dt);
+            float aimDifference = RotateTurret(transform, turret, targetTransform.position, dt);
 
-                if (turret.fireCooldown <= 0.0f && std::abs(aimDifference) < 5.0f &&
-                    HasLineOfSight(transform.position, targetTransform.position))
-                {
-                    FireAtTarget(registry, transform.position, targetTransform.position);
+            if (turret.fireCooldown <= 0.0f && std::abs(aimDifference) < 5.0f &&
+                HasLineOfSight(transform.position, targetTransform.position))
+            {
+                shots.push_back({ entity, transform.position, targetTransform.position });
 
-                    if (turret.currentAmmo > 0) {
-                        turret.currentAmmo--;
-                        turret.fireCooldown = turret.burstDelay;
-                    }
-                    if (turret.currentAmmo == 0) {
-                        turret.fireCooldown = turret.reloadTime;
-                        turret.currentAmmo = turret.shotsInBurst;
-                        auto& selfHealth = registry->GetComponent<HealthComponent>(entity);
-                        selfHealth.currentHP -= turret.selfDamagePerBurst;
-                    }
+                if (turret.currentAmmo > 0) {
+                    turret.currentAmmo--;
+                    turret.fireCooldown = turret.burstDelay;
+                }
+                if (turret.currentAmmo == 0) {
+                    turret.fireCooldown = turret.reloadTime;
+                    turret.currentAmmo = turret.shotsInBurst;
+                    auto& selfHealth = registry->GetComponent<HealthComponent>(entity);
+                    selfHealth.currentHP -= turret.selfDamagePerBurst;
                 }
             }
         }
     }
 
     bool IsTargetValid(ecs::Registry* registry, ecs::Entity target, const TransformComponent& turretTransform, float range) {
-        if (target == ecs::MAX_ENTITIES) return false;
-        if (!registry->HasComponent<HealthComponent>(target)) return false;
+        if (!registry->IsAlive(target)) return false;
         auto& targetTransform = registry->GetComponent<TransformComponent>(target);
         return glm::distance(turretTransform.position, targetTransform.position) <= range;
     }
 
-    void FindTargetForTurret(ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies, ecs::Entity turretEntity) {
-        auto& turret = m_Registry->GetComponent<TurretAIComponent>(turretEntity);
-        auto& transform = m_Registry->GetComponent<TransformComponent>(turretEntity);
+    void FindTargetForTurret(ecs::Registry* registry, TurretAIComponent& turret, const TransformComponent& transform) {
         float closestDist = turret.range + 1.0f;
         std::optional<ecs::Entity> bestTarget = std::nullopt;
 
-        for (auto const& enemyEntity : allEnemies) {
-            if (!registry->HasComponent<HealthComponent>(enemyEntity)) continue;
+        float yawRad = glm::radians(transform.rotation.y);
+        glm::vec3 turretForward = glm::vec3(cos(yawRad), 0.0f, sin(yawRad));
+        float cosHalfFov = cos(glm::radians(turret.fovDegrees / 2.0f));
 
-            auto& enemyTransform = registry->GetComponent<TransformComponent>(enemyEntity);
-            float dist = glm::distance(transform.position, enemyTransform.position);
+        //the hash snapshot is taken at the start of the tick and enemies have not moved yet, so its positions are current
+        m_Spatial->GetEnemies().QueryRadius(transform.position, closestDist, [&](ecs::Entity enemyEntity, const glm::vec3& enemyPosition) {
+            float dist = glm::distance(transform.position, enemyPosition);
+            if (dist >= closestDist || !registry->HasComponent<HealthComponent>(enemyEntity)) return;
 
-            if (dist < closestDist && IsTargetInFOV(transform, enemyTransform, turret)) {
+            if (IsTargetInFOV(transform.position, turretForward, cosHalfFov, enemyPosition)) {
                 closestDist = dist;
                 bestTarget = enemyEntity;
             }
-        }
+        });
 
         if (bestTarget) {
             turret.currentTarget = *bestTarget;
         }
         else {
-            turret.currentTarget = ecs::MAX_ENTITIES;
+            turret.currentTarget = ecs::NULL_ENTITY;
         }
     }
 
@@ -116,68 +178,34 @@ private:
         return diff - turn; // Return the remaining difference
     }
 
-    bool IsTargetInFOV(const TransformComponent& turretTransform, const TransformComponent& targetTransform, const TurretAIComponent& turret) {
-
-        float yawRad = glm::radians(turretTransform.rotation.y);
-        glm::vec3 turretForward = glm::vec3(cos(yawRad), 0.0f, sin(yawRad));
-
-        glm::vec3 toTarget = glm::normalize(targetTransform.position - turretTransform.position);
-        float angle = glm::degrees(acos(glm::dot(turretForward, toTarget)));
-
-        return (angle < turret.fovDegrees / 2.0f);
+    //angle < fov/2 compared as cosines, the forward vector and cos(fov/2) are worked out once per turret
+    bool IsTargetInFOV(const glm::vec3& turretPos, const glm::vec3& turretForward, float cosHalfFov, const glm::vec3& targetPos) {
+        glm::vec3 toTarget = glm::normalize(targetPos - turretPos);
+        return glm::dot(turretForward, toTarget) > cosHalfFov;
     }
 
     bool HasLineOfSight(glm::vec3 start, glm::vec3 end) {
-        glm::ivec2 startTile = m_GridSystem->WorldToGrid(start);
-        glm::ivec2 endTile = m_GridSystem->WorldToGrid(end);
-
-        //bresenhams algo to draw a line bw turr and target(los)
-        int x0 = startTile.x, y0 = startTile.y;
-        int x1 = endTile.x, y1 = endTile.y;
-        int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-        int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-        int err = dx + dy, e2;
-
-        while (true) {
-
-            if (x0 != startTile.x || y0 != startTile.y) {
-                if (m_GridSystem->IsTileOccupied(x0, y0)) {
-                    return false;
-                }
-            }
-            if (x0 == x1 && y0 == y1) break;
-            e2 = 2 * err;
-            if (e2 >= dy) { err += dy; x0 += sx; }
-            if (e2 <= dx) { err += dx; y0 += sy; }
-        }
-        return true; //no obstructions
+        return m_GridSystem->HasLineOfSight(m_GridSystem->WorldToGrid(start), m_GridSystem->WorldToGrid(end));
     }
 
-    void FireAtTarget(ecs::Registry* registry, glm::vec3 turretPos, glm::vec3 targetPos) {
-        auto bullet = registry->CreateEntity();
-
+    void FireAtTarget(glm::vec3 turretPos, glm::vec3 targetPos) {
         //spawn bullet above the turret
         turretPos.y += 0.5f;
-
-        registry->AddComponent(bullet, TransformComponent{
-            turretPos,
-            {0.2f, 0.2f, 0.2f},
-            {0,0,0}
-            });
-        registry->AddComponent(bullet, RenderComponent{ {1.0f, 0.5f, 0.0f, 1.0f} }); // Orange
-        registry->AddComponent(bullet, MeshComponent{ MeshType::Sphere });
-
         glm::vec3 velocity = glm::normalize(targetPos - turretPos) * 15.0f; //15 units per sec
-        registry->AddComponent(bullet, ProjectileComponent{ velocity, 4 }); //4 damage
+
+        //turrets are still being iterated here, so the bullet is created at the next sync point
+        m_Commands.Spawn(Prefabs::Projectile(), [turretPos, velocity](ecs::Registry& registry, ecs::Entity bullet) {
+            registry.GetComponent<TransformComponent>(bullet).position = turretPos;
+            registry.GetComponent<ProjectileComponent>(bullet).velocity = velocity;
+        });
     }
 
-    void UpdateEnemies(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies) {
-        for (auto const& entity : allEnemies) {
-            auto& movement = registry->GetComponent<MovementComponent>(entity);
+    void UpdateEnemies(float dt, ecs::Registry* registry) {
+        registry->View<EnemyComponent, MovementComponent>().Each([&](ecs::Entity entity, EnemyComponent&, MovementComponent& movement) {
             if (movement.isAttacking) {
                 movement.attackCooldown -= dt;
                 if (movement.attackCooldown <= 0.0f) {
-                    if (registry->HasComponent<HealthComponent>(movement.targetEntity)) {
+                    if (registry->IsAlive(movement.targetEntity)) {
                         auto& targetHealth = registry->GetComponent<HealthComponent>(movement.targetEntity);
                         targetHealth.currentHP -= 5;
                         std::cout << "Enemy " << entity << " attacks " << movement.targetEntity << "! HP: " << targetHealth.currentHP << std::endl;
@@ -185,43 +213,38 @@ private:
                     movement.attackCooldown = movement.attackRate;
                 }
             }
-        }
+        });
     }
 
-    void UpdateBombs(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies, const std::set<ecs::Entity>& allRenderableEntities) {
-        for (auto const& entity : allRenderableEntities) {
-            if (!registry->HasComponent<BombComponent>(entity)) continue;
-
-            auto& bomb = registry->GetComponent<BombComponent>(entity);
-            auto& transform = registry->GetComponent<TransformComponent>(entity);
-
-            for (auto const& enemy : allEnemies) {
+    void UpdateBombs(ecs::Registry* registry) {
+        registry->View<BombComponent, TransformComponent, HealthComponent>().Each([&](ecs::Entity, BombComponent& bomb, TransformComponent& transform, HealthComponent& health) {
+            m_Spatial->GetEnemies().QueryRadius(transform.position, bomb.triggerRadius, [&](ecs::Entity enemy, const glm::vec3&) {
+                if (health.currentHP <= 0 || !registry->HasComponent<MovementComponent>(enemy)) return;
                 auto& enemyT = registry->GetComponent<TransformComponent>(enemy);
                 if (glm::distance(transform.position, enemyT.position) < bomb.triggerRadius) {
 
-                    registry->GetComponent<HealthComponent>(entity).currentHP = 0;
-                    break;
+                    health.currentHP = 0;
                 }
-            }
-        }
+            });
+        });
     }
 
-    void CheckForDeaths(ecs::Registry* registry, const std::set<ecs::Entity>& allRenderableEntities) {
-        std::set<ecs::Entity> deadEntities;
-        for (auto const& entity : allRenderableEntities) {
-            if (registry->HasComponent<HealthComponent>(entity)) {
-                if (registry->GetComponent<HealthComponent>(entity).currentHP <= 0.0f) {
-                    deadEntities.insert(entity);
-                }
+    //deaths can kill more entities (bomb blasts catching other bombs); those are appended to the list
+    //and handled in this same pass, so a whole chain reaction resolves in one tick
+    void CheckForDeaths(ecs::Registry* registry) {
+        std::vector<ecs::Entity> dying;
+        registry->View<HealthComponent>().Each([&](ecs::Entity entity, HealthComponent& health) {
+            if (health.currentHP <= 0.0f) {
+                dying.push_back(entity);
             }
-        }
+        });
 
-        for (auto const& entity : deadEntities) {
-            OnEntityDied(registry, entity);
+        for (size_t i = 0; i < dying.size(); ++i) {
+            OnEntityDied(registry, dying[i], dying);
         }
     }
 
-    void OnEntityDied(ecs::Registry* registry, ecs::Entity entity) {
+    void OnEntityDied(ecs::Registry* registry, ecs::Entity entity, std::vector<ecs::Entity>& dying) {
         if (!registry->HasComponent<HealthComponent>(entity)) return;
 
         if (registry->HasComponent<EnemyComponent>(entity)) {
@@ -251,7 +274,7 @@ private:
 
             for (int x = 0; x < footprintX; ++x) {
                 for (int z = 0; z < footprintZ; ++z) {
-                    m_GridSystem->SetEntityAt(anchor.x + x, anchor.y + z, ecs::MAX_ENTITIES);
+                    m_GridSystem->SetEntityAt(anchor.x + x, anchor.y + z, ecs::NULL_ENTITY);
                 }
             }
 
@@ -260,20 +283,11 @@ private:
                 std::cout << "BOMB " << entity << " EXPLODES!" << std::endl;
                 auto& bomb = registry->GetComponent<BombComponent>(entity);
 
-                //find all surrounding entities with health and damage em
-                for (ecs::Entity target = 0; target < ecs::MAX_ENTITIES; ++target) {
-                    if (!registry->HasComponent<HealthComponent>(target)) continue;
-                    if (target == entity) continue;
-
-                    auto& targetT = registry->GetComponent<TransformComponent>(target);
-                    if (glm::distance(transform.position, targetT.position) < bomb.blastRadius) {
-                        auto& health = registry->GetComponent<HealthComponent>(target);
-                        health.currentHP -= bomb.damage;
-                    }
-                }
+                std::vector<ecs::Entity> killed = ApplyRadialDamage(transform.position, bomb.blastRadius, bomb.damage);
+                dying.insert(dying.end(), killed.begin(), killed.end());
             }
         }
 
-        registry->DestroyEntity(entity);
+        m_Commands.DestroyEntity(entity);
     }
 };
\ No newline at end of file
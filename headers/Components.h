@@ -82,7 +82,7 @@ struct TurretAIComponent {
     float range = 8.0f;
     float fovDegrees = 90.0f;
     float turnSpeed = 90.0f; //degrees per second
-    ecs::Entity currentTarget = ecs::MAX_ENTITIES;
+    ecs::Entity currentTarget = ecs::NULL_ENTITY;
 
     //self inflicted damage
     int selfDamagePerBurst = 5;
@@ -95,13 +95,31 @@ struct TurretAIComponent {
     int currentAmmo = 5;
 };
 
+//a tile path stored in the PathPool. length is kept here too so movement can tell how far along it is without
+//asking the pool; a default handle is the empty path
+struct PathHandle {
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFF;
+    uint32_t slot = NO_SLOT;
+    uint32_t generation = 0;
+    uint32_t length = 0;
+
+    bool Empty() const { return length == 0; }
+    size_t Size() const { return length; }
+    void Clear() { *this = PathHandle(); }
+};
+
 struct MovementComponent {
     float speed = 2.0f;
-    std::vector<glm::vec3> path;
+    PathHandle path; //tiles in the PathPool, turned into world positions one waypoint at a time
     int currentPathIndex = 0;
+    uint32_t pathStamp = 0; //bumped by EnemyAISystem for every path it hands out, keys its tile -> path index
+
+    //hierarchical pathing: entrance tiles still ahead, path only holds the leg up to the next one
+    PathHandle coarsePath;
+    int coarsePathIndex = 0;
 
     //lock on functionality
-    ecs::Entity targetEntity = ecs::MAX_ENTITIES; //actual building the enemy latched onto
+    ecs::Entity targetEntity = ecs::NULL_ENTITY; //actual building the enemy latched onto
     bool isAttacking = false;
     short attackRate = 1;
     float attackCooldown = 0.0f;
@@ -1,4 +1,11 @@
+#pragma once
+
 constexpr int baseHealth = 500;
 constexpr int turretHealth = 100;
 constexpr int resourceNodeHealth = 50;
-constexpr int bombHealth = 1;
\ No newline at end of file
+constexpr int bombHealth = 1;
+
+constexpr double fixedTimeStep = 0.01; //seconds per simulation tick
+
+constexpr int defaultMapWidth = 20; //tiles
+constexpr int defaultMapHeight = 20;
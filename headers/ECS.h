@@ -3,110 +3,240 @@
 #include <iostream>
 #include <vector>
 #include <memory>
-#include <unordered_map>
-#include <set>
 #include <array>
 #include <cassert>
-#include <queue>
 #include <bitset>
 #include <algorithm> 
+#include <tuple>
+#include <utility>
+#include <functional>
 
 namespace ecs {
 
+    //handles pack a slot index (low bits) with a generation (high bits) that is bumped every time the slot is freed,
+    //so a handle kept around after its entity died never matches whatever reuses the slot
     using Entity = uint32_t;
-    constexpr Entity MAX_ENTITIES = 5000;
+    constexpr uint32_t ENTITY_INDEX_BITS = 20;
+    constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+    constexpr uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+    constexpr uint32_t TEMPORARY_GENERATION = ENTITY_GENERATION_MASK; //never handed out by the registry, marks CommandBuffer handles
+    constexpr Entity NULL_ENTITY = UINT32_MAX;
+    constexpr Entity MAX_ENTITIES = ENTITY_INDEX_MASK; //the all-ones index is left to NULL_ENTITY
     using ComponentTypeID = uint8_t;
     constexpr ComponentTypeID MAX_COMPONENTS = 32;
     using Signature = std::bitset<MAX_COMPONENTS>;
-
-
+    using SystemTypeID = uint8_t;
+    constexpr SystemTypeID MAX_SYSTEMS = 32;
+
+    //dense type ids, handed out once per type the first time it is asked for
+    inline ComponentTypeID NextComponentTypeID() {
+        static ComponentTypeID next = 0;
+        return next++;
+    }
+    template<typename T>
+    ComponentTypeID ComponentType() {
+        static const ComponentTypeID id = NextComponentTypeID();
+        return id;
+    }
+
+    inline SystemTypeID NextSystemTypeID() {
+        static SystemTypeID next = 0;
+        return next++;
+    }
+    template<typename T>
+    SystemTypeID SystemType() {
+        static const SystemTypeID id = NextSystemTypeID();
+        return id;
+    }
+
+    constexpr uint32_t GetEntityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+    constexpr uint32_t GetEntityGeneration(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+    constexpr Entity MakeEntity(uint32_t index, uint32_t generation) {
+        return (generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+    }
+    constexpr uint32_t NextGeneration(uint32_t generation) { return (generation + 1) % TEMPORARY_GENERATION; }
+    constexpr bool IsTemporaryEntity(Entity entity) {
+        return entity != NULL_ENTITY && GetEntityGeneration(entity) == TEMPORARY_GENERATION;
+    }
+
+
+    //slots are handed out on demand, so nothing is allocated for ids that were never used.
+    //free slots form an intrusive doubly linked list (oldest freed first), which lets a specific
+    //id be pulled out of the middle in O(1) when a save is loaded
     class EntityManager {
     public:
-        EntityManager() {
-            for (Entity e = 0; e < MAX_ENTITIES; ++e) {
-                m_AvailableEntities.push(e);
-            }
-            m_LivingEntityCount = 0;
-        }
-
         Entity CreateEntity() {
             assert(m_LivingEntityCount < MAX_ENTITIES && "Max entities exceeded");
 
-            Entity id = m_AvailableEntities.front();
-            m_AvailableEntities.pop();
-            ++m_LivingEntityCount;
-            m_LivingEntities.insert(id);
-            return id;
+            if (m_FreeHead == INVALID_SLOT) {
+                GrowSlots(static_cast<uint32_t>(m_Handles.size()) + 1);
+            }
+            uint32_t index = m_FreeHead;
+            Unlink(index);
+            return Claim(index, m_Generations[index]);
         }
 
+        //recreates a specific handle (save loading), generation included
         Entity CreateEntity(Entity id) {
-            assert(id < MAX_ENTITIES && "Entity ID out of range");
-
-            std::queue<Entity> temp;
-            bool found = false;
-            while (!m_AvailableEntities.empty()) {
-                Entity e = m_AvailableEntities.front();
-                m_AvailableEntities.pop();
-                if (e == id) {
-                    found = true;
-                }
-                else {
-                    temp.push(e);
-                }
+            uint32_t index = GetEntityIndex(id);
+            assert(index < MAX_ENTITIES && "Entity ID out of range");
+            assert(!IsTemporaryEntity(id) && "Temporary handles cannot be recreated");
+
+            if (index >= m_Handles.size()) {
+                GrowSlots(index + 1);
             }
-            m_AvailableEntities = temp;
+            assert(m_Handles[index] == NULL_ENTITY && "Trying to create an entity ID that was already in use");
 
-            assert(found && "Trying to create an entity ID that was already in use");
+            Unlink(index);
+            return Claim(index, GetEntityGeneration(id));
+        }
 
-            ++m_LivingEntityCount;
-            m_LivingEntities.insert(id);
-            return id;
+        //bulk version of CreateEntity(id) for ids sorted by index; slots are grown once up to the last one
+        void CreateEntities(const std::vector<Entity>& ids) {
+            if (ids.empty()) return;
+            assert(std::is_sorted(ids.begin(), ids.end(), [](Entity a, Entity b) { return GetEntityIndex(a) < GetEntityIndex(b); }) && "Entity IDs must be sorted");
+
+            uint32_t last = GetEntityIndex(ids.back());
+            assert(last < MAX_ENTITIES && "Entity ID out of range");
+            if (last >= m_Handles.size()) {
+                GrowSlots(last + 1);
+            }
+            m_LivingEntities.reserve(m_LivingEntities.size() + ids.size());
+            for (Entity id : ids) {
+                CreateEntity(id);
+            }
         }
 
         void DestroyEntity(Entity entity) {
-            assert(entity < MAX_ENTITIES && "Entity out of range");
+            assert(IsAlive(entity) && "Destroying dead or stale entity");
+            uint32_t index = GetEntityIndex(entity);
 
-            m_Signatures[entity].reset();
-            m_AvailableEntities.push(entity);
+            m_Signatures[index].reset();
+            m_Handles[index] = NULL_ENTITY;
+            m_Generations[index] = NextGeneration(m_Generations[index]);
+            PushFree(index);
             --m_LivingEntityCount;
-            m_LivingEntities.erase(entity);
+
+            //swap-remove out of the living list
+            uint32_t position = m_LivingPosition[index];
+            Entity moved = m_LivingEntities.back();
+            m_LivingEntities[position] = moved;
+            m_LivingPosition[GetEntityIndex(moved)] = position;
+            m_LivingEntities.pop_back();
+        }
+
+        bool IsAlive(Entity entity) const {
+            uint32_t index = GetEntityIndex(entity);
+            return index < m_Handles.size() && m_Handles[index] == entity;
         }
 
         void SetSignature(Entity entity, Signature signature) {
-            assert(entity < MAX_ENTITIES && "Entity out of range");
-            m_Signatures[entity] = signature;
+            assert(GetEntityIndex(entity) < m_Signatures.size() && "Entity out of range");
+            m_Signatures[GetEntityIndex(entity)] = signature;
         }
 
         Signature GetSignature(Entity entity) const {
-            assert(entity < MAX_ENTITIES && "Entity out of range");
-            return m_Signatures[entity];
+            assert(GetEntityIndex(entity) < m_Signatures.size() && "Entity out of range");
+            return m_Signatures[GetEntityIndex(entity)];
         }
 
         uint32_t GetLivingEntityCount() const {
             return m_LivingEntityCount;
         }
 
-        const std::set<Entity>& GetLivingEntities() const {
+        //unordered
+        const std::vector<Entity>& GetLivingEntities() const {
             return m_LivingEntities;
         }
 
+        size_t GetMemoryUsage() const {
+            return m_Signatures.capacity() * sizeof(Signature) +
+                m_Handles.capacity() * sizeof(Entity) +
+                m_Generations.capacity() * sizeof(uint32_t) +
+                m_NextFree.capacity() * sizeof(uint32_t) +
+                m_PrevFree.capacity() * sizeof(uint32_t) +
+                m_LivingPosition.capacity() * sizeof(uint32_t) +
+                m_LivingEntities.capacity() * sizeof(Entity);
+        }
+
+        //generations of everything still alive are bumped so handles from the cleared world stay dead.
+        //slots are kept and handed out again from index 0
         void Reset() {
+            for (Entity entity : m_LivingEntities) {
+                uint32_t index = GetEntityIndex(entity);
+                m_Generations[index] = NextGeneration(m_Generations[index]);
+            }
             m_LivingEntityCount = 0;
             m_LivingEntities.clear();
 
-            std::queue<Entity> empty;
-            std::swap(m_AvailableEntities, empty);
-            for (Entity e = 0; e < MAX_ENTITIES; ++e) {
-                m_AvailableEntities.push(e);
-                m_Signatures[e].reset();
+            m_FreeHead = INVALID_SLOT;
+            m_FreeTail = INVALID_SLOT;
+            for (uint32_t index = 0; index < m_Handles.size(); ++index) {
+                m_Handles[index] = NULL_ENTITY;
+                m_Signatures[index].reset();
+                PushFree(index);
             }
         }
 
     private:
-        std::queue<Entity> m_AvailableEntities{};
-        std::array<Signature, MAX_ENTITIES> m_Signatures{};
+        static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+        std::vector<Signature> m_Signatures{};
+        std::vector<Entity> m_Handles{};
+        std::vector<uint32_t> m_Generations{};
+        std::vector<uint32_t> m_NextFree{};
+        std::vector<uint32_t> m_PrevFree{};
+        uint32_t m_FreeHead = INVALID_SLOT;
+        uint32_t m_FreeTail = INVALID_SLOT;
         uint32_t m_LivingEntityCount{};
-        std::set<Entity> m_LivingEntities{};
+        std::vector<Entity> m_LivingEntities{};
+        std::vector<uint32_t> m_LivingPosition{};
+
+        Entity Claim(uint32_t index, uint32_t generation) {
+            Entity id = MakeEntity(index, generation);
+            m_Generations[index] = generation;
+            m_Handles[index] = id;
+            m_LivingPosition[index] = static_cast<uint32_t>(m_LivingEntities.size());
+            m_LivingEntities.push_back(id);
+            ++m_LivingEntityCount;
+            return id;
+        }
+
+        //new slots join the back of the free list in index order
+        void GrowSlots(uint32_t count) {
+            assert(count <= MAX_ENTITIES && "Max entities exceeded");
+            uint32_t first = static_cast<uint32_t>(m_Handles.size());
+            m_Signatures.resize(count);
+            m_Handles.resize(count, NULL_ENTITY);
+            m_Generations.resize(count, 0);
+            m_NextFree.resize(count, INVALID_SLOT);
+            m_PrevFree.resize(count, INVALID_SLOT);
+            m_LivingPosition.resize(count, INVALID_SLOT);
+            for (uint32_t index = first; index < count; ++index) {
+                PushFree(index);
+            }
+        }
+
+        void PushFree(uint32_t index) {
+            m_NextFree[index] = INVALID_SLOT;
+            m_PrevFree[index] = m_FreeTail;
+            if (m_FreeTail != INVALID_SLOT) {
+                m_NextFree[m_FreeTail] = index;
+            }
+            else {
+                m_FreeHead = index;
+            }
+            m_FreeTail = index;
+        }
+
+        void Unlink(uint32_t index) {
+            uint32_t prev = m_PrevFree[index];
+            uint32_t next = m_NextFree[index];
+            if (prev != INVALID_SLOT) m_NextFree[prev] = next; else m_FreeHead = next;
+            if (next != INVALID_SLOT) m_PrevFree[next] = prev; else m_FreeTail = prev;
+            m_NextFree[index] = INVALID_SLOT;
+            m_PrevFree[index] = INVALID_SLOT;
+        }
     };
 
 
@@ -115,42 +245,107 @@ namespace ecs {
         virtual ~IComponentArray() = default;
         virtual void EntityDestroyed(Entity entity) = 0;
         virtual void Reset() = 0;
+        virtual size_t GetMemoryUsage() const = 0;
+    };
+
+    //entity slot -> dense index lookup, split into fixed pages so sparse ids only cost the pages they touch
+    constexpr size_t SPARSE_PAGE_SIZE = 1024;
+    constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    class SparseIndex {
+    public:
+        uint32_t Get(Entity entity) const {
+            uint32_t index = GetEntityIndex(entity);
+            size_t page = index / SPARSE_PAGE_SIZE;
+            if (page >= m_Pages.size() || !m_Pages[page]) {
+                return INVALID_INDEX;
+            }
+            return (*m_Pages[page])[index % SPARSE_PAGE_SIZE];
+        }
+
+        void Set(Entity entity, uint32_t denseIndex) {
+            uint32_t index = GetEntityIndex(entity);
+            size_t page = index / SPARSE_PAGE_SIZE;
+            if (page >= m_Pages.size()) {
+                m_Pages.resize(page + 1);
+            }
+            if (!m_Pages[page]) {
+                m_Pages[page] = std::make_unique<Page>();
+                m_Pages[page]->fill(INVALID_INDEX);
+            }
+            (*m_Pages[page])[index % SPARSE_PAGE_SIZE] = denseIndex;
+        }
+
+        void Clear() {
+            m_Pages.clear();
+        }
+
+        size_t GetMemoryUsage() const {
+            size_t allocated = 0;
+            for (auto const& page : m_Pages) {
+                if (page) allocated += sizeof(Page);
+            }
+            return allocated + m_Pages.capacity() * sizeof(std::unique_ptr<Page>);
+        }
+
+    private:
+        using Page = std::array<uint32_t, SPARSE_PAGE_SIZE>;
+        std::vector<std::unique_ptr<Page>> m_Pages;
     };
 
+    //dense component storage is split into fixed pages that are never moved, so growing the pool
+    //does not invalidate references (swap-remove still moves the last element into the hole)
+    constexpr size_t COMPONENT_PAGE_SIZE = 1024;
+
     template<typename T>
     class ComponentArray : public IComponentArray {
     public:
         void InsertData(Entity entity, T component) {
-            assert(m_EntityToIndexMap.find(entity) == m_EntityToIndexMap.end() && "Component added twice");
-            size_t newIndex = m_Size;
-            m_EntityToIndexMap[entity] = newIndex;
-            m_IndexToEntityMap[newIndex] = entity;
-            m_ComponentArray[newIndex] = component;
-            ++m_Size;
+            assert(!HasData(entity) && "Component added twice");
+            uint32_t newIndex = static_cast<uint32_t>(m_DenseEntities.size());
+            if (newIndex / COMPONENT_PAGE_SIZE >= m_Pages.size()) {
+                m_Pages.push_back(std::make_unique<T[]>(COMPONENT_PAGE_SIZE));
+            }
+            m_Sparse.Set(entity, newIndex);
+            m_DenseEntities.push_back(entity);
+            DataAt(newIndex) = std::move(component);
         }
 
         void RemoveData(Entity entity) {
-            assert(m_EntityToIndexMap.find(entity) != m_EntityToIndexMap.end() && "Removing non-existent component");
-            size_t indexOfRemoved = m_EntityToIndexMap[entity];
-            size_t indexOfLast = m_Size - 1;
-            m_ComponentArray[indexOfRemoved] = m_ComponentArray[indexOfLast];
-            Entity entityOfLast = m_IndexToEntityMap[indexOfLast];
-            m_EntityToIndexMap[entityOfLast] = indexOfRemoved;
-            m_IndexToEntityMap[indexOfRemoved] = entityOfLast;
-            m_EntityToIndexMap.erase(entity);
-            m_IndexToEntityMap.erase(indexOfLast);
-            --m_Size;
+            assert(HasData(entity) && "Removing non-existent component");
+            uint32_t indexOfRemoved = m_Sparse.Get(entity);
+            uint32_t indexOfLast = static_cast<uint32_t>(m_DenseEntities.size() - 1);
+            Entity entityOfLast = m_DenseEntities[indexOfLast];
+            if (indexOfRemoved != indexOfLast) {
+                DataAt(indexOfRemoved) = std::move(DataAt(indexOfLast));
+            }
+            DataAt(indexOfLast) = T{};
+            m_DenseEntities[indexOfRemoved] = entityOfLast;
+            m_Sparse.Set(entityOfLast, indexOfRemoved);
+            m_Sparse.Set(entity, INVALID_INDEX);
+            m_DenseEntities.pop_back();
         }
 
         T& GetData(Entity entity) {
-            assert(m_EntityToIndexMap.find(entity) != m_EntityToIndexMap.end() && "Retrieving non-existent component");
-            return m_ComponentArray[m_EntityToIndexMap[entity]];
+            assert(HasData(entity) && "Retrieving non-existent component");
+            return DataAt(m_Sparse.Get(entity));
         }
 
-        bool HasData(Entity entity) {
-            return m_EntityToIndexMap.find(entity) != m_EntityToIndexMap.end();
+        bool HasData(Entity entity) const {
+            return IndexOf(entity) != INVALID_INDEX;
         }
 
+        //dense slot of the entity's component, INVALID_INDEX if it has none
+        uint32_t IndexOf(Entity entity) const {
+            uint32_t index = m_Sparse.Get(entity);
+            return (index < m_DenseEntities.size() && m_DenseEntities[index] == entity) ? index : INVALID_INDEX;
+        }
+
+        T& DataAt(uint32_t index) { return m_Pages[index / COMPONENT_PAGE_SIZE][index % COMPONENT_PAGE_SIZE]; }
+
+        size_t Size() const { return m_DenseEntities.size(); }
+        const std::vector<Entity>& Entities() const { return m_DenseEntities; }
+
         void EntityDestroyed(Entity entity) override {
             if (HasData(entity)) {
                 RemoveData(entity);
@@ -158,16 +353,115 @@ namespace ecs {
         }
 
         void Reset() override {
-            m_EntityToIndexMap.clear();
-            m_IndexToEntityMap.clear();
-            m_Size = 0;
+            m_Sparse.Clear();
+            m_DenseEntities.clear();
+            m_DenseEntities.shrink_to_fit();
+            m_Pages.clear();
+        }
+
+        size_t GetMemoryUsage() const override {
+            return m_Pages.size() * COMPONENT_PAGE_SIZE * sizeof(T) +
+                m_Pages.capacity() * sizeof(std::unique_ptr<T[]>) +
+                m_DenseEntities.capacity() * sizeof(Entity) +
+                m_Sparse.GetMemoryUsage();
         }
 
     private:
-        std::array<T, MAX_ENTITIES> m_ComponentArray;
-        std::unordered_map<Entity, size_t> m_EntityToIndexMap;
-        std::unordered_map<size_t, Entity> m_IndexToEntityMap;
-        size_t m_Size{};
+        std::vector<std::unique_ptr<T[]>> m_Pages;
+        std::vector<Entity> m_DenseEntities;
+        SparseIndex m_Sparse;
+    };
+
+
+    template<typename... Ts>
+    struct TypeList {};
+
+    //passed to Registry::View to filter out entities that own any of these components
+    template<typename... Ts>
+    inline constexpr TypeList<Ts...> Exclude{};
+
+    template<typename IncludeList, typename ExcludeList = TypeList<>>
+    class ComponentView;
+
+    //walks the smallest of the included pools and resolves the rest through their sparse index.
+    //entities created mid-iteration are not visited; destroying entities mid-iteration is not supported, collect them instead
+    template<typename... Include, typename... Excluded>
+    class ComponentView<TypeList<Include...>, TypeList<Excluded...>> {
+    public:
+        ComponentView(std::tuple<ComponentArray<Include>*...> include, std::tuple<ComponentArray<Excluded>*...> exclude)
+            : m_Include(include), m_Exclude(exclude) {
+            ((m_Lead = (m_Lead == nullptr || std::get<ComponentArray<Include>*>(m_Include)->Size() < m_Lead->size())
+                ? &std::get<ComponentArray<Include>*>(m_Include)->Entities() : m_Lead), ...);
+        }
+
+        class Iterator {
+        public:
+            Iterator(const ComponentView* view, size_t index, size_t end) : m_View(view), m_Index(index), m_End(end) { Skip(); }
+
+            Entity operator*() const { return (*m_View->m_Lead)[m_Index]; }
+            Iterator& operator++() { ++m_Index; Skip(); return *this; }
+            bool operator==(const Iterator& other) const { return m_Index == other.m_Index; }
+            bool operator!=(const Iterator& other) const { return m_Index != other.m_Index; }
+
+        private:
+            const ComponentView* m_View;
+            size_t m_Index;
+            size_t m_End;
+
+            void Skip() {
+                while (m_Index < m_End) {
+                    if (m_Index >= m_View->m_Lead->size()) {
+                        m_Index = m_End;
+                        break;
+                    }
+                    if (m_View->Contains((*m_View->m_Lead)[m_Index])) break;
+                    ++m_Index;
+                }
+            }
+        };
+
+        Iterator begin() const { return Iterator(this, 0, m_Lead->size()); }
+        Iterator end() const { return Iterator(this, m_Lead->size(), m_Lead->size()); }
+
+        bool Contains(Entity entity) const {
+            return (std::get<ComponentArray<Include>*>(m_Include)->HasData(entity) && ...) &&
+                !(std::get<ComponentArray<Excluded>*>(m_Exclude)->HasData(entity) || ...);
+        }
+
+        template<typename T>
+        T& Get(Entity entity) const { return std::get<ComponentArray<T>*>(m_Include)->GetData(entity); }
+
+        //upper bound on the number of matches (size of the lead pool)
+        size_t SizeHint() const { return m_Lead->size(); }
+
+        //func(entity, Include&...)
+        template<typename Func>
+        void Each(Func func) const {
+            EachImpl(func, 0, m_Lead->size(), std::index_sequence_for<Include...>{});
+        }
+
+        //same as Each but only over lead pool slots [begin, end), so disjoint ranges can be walked from different threads
+        //as long as func only writes to the entity it is handed
+        template<typename Func>
+        void EachInRange(size_t begin, size_t end, Func func) const {
+            EachImpl(func, begin, std::min(end, m_Lead->size()), std::index_sequence_for<Include...>{});
+        }
+
+    private:
+        std::tuple<ComponentArray<Include>*...> m_Include;
+        std::tuple<ComponentArray<Excluded>*...> m_Exclude;
+        const std::vector<Entity>* m_Lead = nullptr;
+
+        template<typename Func, size_t... I>
+        void EachImpl(Func& func, size_t begin, size_t end, std::index_sequence<I...>) const {
+            for (size_t i = begin; i < end && i < m_Lead->size(); ++i) {
+                Entity entity = (*m_Lead)[i];
+                std::array<uint32_t, sizeof...(Include)> slots{ std::get<ComponentArray<Include>*>(m_Include)->IndexOf(entity)... };
+                if (((slots[I] == INVALID_INDEX) || ...)) continue;
+                if ((std::get<ComponentArray<Excluded>*>(m_Exclude)->HasData(entity) || ...)) continue;
+                func(entity, std::get<ComponentArray<Include>*>(m_Include)->DataAt(slots[I])...);
+            }
+        }
     };
 
 
@@ -175,18 +469,16 @@ namespace ecs {
     public:
         template<typename T>
         void RegisterComponent() {
-            const char* typeName = typeid(T).name();
-            assert(m_ComponentTypes.find(typeName) == m_ComponentTypes.end() && "Registering component type more than once");
-            m_ComponentTypes.insert({ typeName, m_NextComponentTypeID });
-            m_ComponentArrays.insert({ typeName, std::make_shared<ComponentArray<T>>() });
-            ++m_NextComponentTypeID;
+            ComponentTypeID id = ComponentType<T>();
+            assert(id < MAX_COMPONENTS && "Too many component types");
+            assert(!m_ComponentArrays[id] && "Registering component type more than once");
+            m_ComponentArrays[id] = std::make_unique<ComponentArray<T>>();
         }
 
         template<typename T>
         ComponentTypeID GetComponentTypeID() const {
-            const char* typeName = typeid(T).name();
-            assert(m_ComponentTypes.find(typeName) != m_ComponentTypes.end() && "Component not registered");
-            return m_ComponentTypes.at(typeName);
+            assert(m_ComponentArrays[ComponentType<T>()] && "Component not registered");
+            return ComponentType<T>();
         }
 
         template<typename T>
@@ -209,38 +501,181 @@ namespace ecs {
             return GetComponentArray<T>()->HasData(entity);
         }
 
-        void EntityDestroyed(Entity entity) {
-            for (auto const& pair : m_ComponentArrays) {
-                pair.second->EntityDestroyed(entity);
+        //only the pools named in the entity's signature can hold its data
+        void EntityDestroyed(Entity entity, Signature signature) {
+            for (ComponentTypeID id = 0; id < MAX_COMPONENTS; ++id) {
+                if (signature.test(id)) {
+                    m_ComponentArrays[id]->EntityDestroyed(entity);
+                }
             }
         }
 
         void Reset() {
-            for (auto const& pair : m_ComponentArrays) {
-                pair.second->Reset();
+            for (auto const& array : m_ComponentArrays) {
+                if (array) {
+                    array->Reset();
+                }
+            }
+        }
+
+        size_t GetMemoryUsage() const {
+            size_t total = 0;
+            for (auto const& array : m_ComponentArrays) {
+                if (array) {
+                    total += array->GetMemoryUsage();
+                }
             }
+            return total;
         }
+
+        template<typename T>
+        ComponentArray<T>* GetComponentArray() {
+            assert(m_ComponentArrays[ComponentType<T>()] && "Component not registered");
+            return static_cast<ComponentArray<T>*>(m_ComponentArrays[ComponentType<T>()].get());
+        }
+
     private:
-        std::unordered_map<const char*, ComponentTypeID> m_ComponentTypes{};
-        std::unordered_map<const char*, std::shared_ptr<IComponentArray>> m_ComponentArrays{};
-        ComponentTypeID m_NextComponentTypeID{};
+        std::array<std::unique_ptr<IComponentArray>, MAX_COMPONENTS> m_ComponentArrays{};
+    };
+
 
+    //a fixed component set with default values, spawned in batches through Registry::Spawn.
+    //the final signature is known up front, so spawning never goes through per-component signature updates
+    class Prefab {
+    public:
         template<typename T>
-        std::shared_ptr<ComponentArray<T>> GetComponentArray() {
-            const char* typeName = typeid(T).name();
-            assert(m_ComponentTypes.find(typeName) != m_ComponentTypes.end() && "Component not registered");
-            return std::static_pointer_cast<ComponentArray<T>>(m_ComponentArrays.at(typeName));
+        Prefab& With(T component) {
+            assert(!m_Signature.test(ComponentType<T>()) && "Component added to prefab twice");
+            m_Signature.set(ComponentType<T>());
+            m_Inserters.push_back([component](ComponentManager& components, const std::vector<Entity>& entities) {
+                auto* array = components.GetComponentArray<T>();
+                for (Entity entity : entities) {
+                    array->InsertData(entity, component);
+                }
+            });
+            return *this;
+        }
+
+        Signature GetSignature() const { return m_Signature; }
+
+        void Insert(ComponentManager& components, const std::vector<Entity>& entities) const {
+            for (auto const& inserter : m_Inserters) {
+                inserter(components, entities);
+            }
         }
+
+    private:
+        Signature m_Signature{};
+        std::vector<std::function<void(ComponentManager&, const std::vector<Entity>&)>> m_Inserters;
+    };
+
+
+    //system membership: a dense entity vector plus a sparse slot -> position index, so insert/erase are O(1)
+    //and iteration is contiguous. erase swaps the last member into the hole, order is not kept
+    class EntitySet {
+    public:
+        bool Contains(Entity entity) const {
+            uint32_t position = m_Positions.Get(entity);
+            return position < m_Dense.size() && m_Dense[position] == entity;
+        }
+
+        void Insert(Entity entity) {
+            if (Contains(entity)) return;
+            m_Positions.Set(entity, static_cast<uint32_t>(m_Dense.size()));
+            m_Dense.push_back(entity);
+        }
+
+        void Erase(Entity entity) {
+            if (!Contains(entity)) return;
+            uint32_t position = m_Positions.Get(entity);
+            Entity moved = m_Dense.back();
+            m_Dense[position] = moved;
+            m_Positions.Set(moved, position);
+            m_Positions.Set(entity, INVALID_INDEX);
+            m_Dense.pop_back();
+        }
+
+        void Clear() {
+            m_Dense.clear();
+            m_Positions.Clear();
+        }
+
+        size_t size() const { return m_Dense.size(); }
+        bool empty() const { return m_Dense.empty(); }
+        std::vector<Entity>::const_iterator begin() const { return m_Dense.begin(); }
+        std::vector<Entity>::const_iterator end() const { return m_Dense.end(); }
+
+    private:
+        std::vector<Entity> m_Dense;
+        SparseIndex m_Positions;
     };
 
 
     class Registry; // Forward declare
 
+    //records structural changes (create/destroy/add/remove) so they can be made while views are being walked,
+    //then applies them in one pass at a sync point. CreateEntity/Spawn return temporary handles that are only
+    //meaningful inside the same buffer; they resolve to real entities during Playback
+    class CommandBuffer {
+    public:
+        Entity CreateEntity() {
+            return PushCreate(nullptr, nullptr);
+        }
+
+        //initializer(registry, entity) runs once the prefab's components exist
+        Entity Spawn(const Prefab& prefab, std::function<void(Registry&, Entity)> initializer = nullptr) {
+            return PushCreate(&prefab, std::move(initializer));
+        }
+
+        void DestroyEntity(Entity entity) {
+            m_Destroys.push_back(entity);
+        }
+
+        //adding a component the entity already has overwrites it, so the last recorded add wins
+        template<typename T>
+        void AddComponent(Entity entity, T component);
+
+        //removing a component the entity no longer has is a no-op
+        template<typename T>
+        void RemoveComponent(Entity entity);
+
+        bool Empty() const { return m_Creates.empty() && m_Destroys.empty() && m_ComponentCommands.empty(); }
+
+        void Playback(Registry& registry);
+
+    private:
+        struct CreateCommand {
+            const Prefab* prefab;
+            std::function<void(Registry&, Entity)> initializer;
+        };
+        struct ComponentCommand {
+            Entity entity;
+            ComponentTypeID type;
+            std::function<void(Registry&, Entity)> apply;
+        };
+
+        std::vector<CreateCommand> m_Creates;
+        std::vector<Entity> m_Destroys;
+        std::vector<ComponentCommand> m_ComponentCommands;
+
+        Entity PushCreate(const Prefab* prefab, std::function<void(Registry&, Entity)> initializer) {
+            Entity temporary = MakeEntity(static_cast<uint32_t>(m_Creates.size()), TEMPORARY_GENERATION);
+            m_Creates.push_back({ prefab, std::move(initializer) });
+            return temporary;
+        }
+
+        void PushComponentCommand(Entity entity, ComponentTypeID type, std::function<void(Registry&, Entity)> apply) {
+            m_ComponentCommands.push_back({ entity, type, std::move(apply) });
+        }
+    };
+
+
     class System {
     public:
         virtual ~System() = default;
-        std::set<Entity> m_Entities;
+        EntitySet m_Entities;
         Registry* m_Registry = nullptr;
+        CommandBuffer m_Commands; //played back by the game loop at its sync points
     };
 
 
@@ -248,58 +683,95 @@ namespace ecs {
     public:
         template<typename T>
         std::shared_ptr<T> RegisterSystem(Registry* registry) {
-            const char* typeName = typeid(T).name();
-            assert(m_Systems.find(typeName) == m_Systems.end() && "Registering system more than once");
+            SystemTypeID id = SystemType<T>();
+            assert(id < MAX_SYSTEMS && "Too many system types");
+            assert(!m_Systems[id] && "Registering system more than once");
             auto system = std::make_shared<T>();
             system->m_Registry = registry;
-            m_Systems.insert({ typeName, system });
+            m_Systems[id] = system;
             return system;
         }
 
         template<typename T>
-        std::shared_ptr<T> GetSystem() const {
-            const char* typeName = typeid(T).name();
-            assert(m_Systems.find(typeName) != m_Systems.end() && "System not registered");
-            return std::static_pointer_cast<T>(m_Systems.at(typeName));
+        T* GetSystem() const {
+            assert(m_Systems[SystemType<T>()] && "System not registered");
+            return static_cast<T*>(m_Systems[SystemType<T>()].get());
         }
 
+        //systems are indexed by every component bit in their signature; an empty signature matches every entity
         template<typename T>
         void SetSignature(Signature signature) {
-            const char* typeName = typeid(T).name();
-            assert(m_Systems.find(typeName) != m_Systems.end() && "System not registered");
-            m_Signatures.insert({ typeName, signature });
+            SystemTypeID id = SystemType<T>();
+            assert(m_Systems[id] && "System not registered");
+            assert(!m_HasSignature.test(id) && "System signature set more than once");
+            m_Signatures[id] = signature;
+            m_HasSignature.set(id);
+
+            if (signature.none()) {
+                m_UniversalSystems.push_back(id);
+                return;
+            }
+            for (ComponentTypeID bit = 0; bit < MAX_COMPONENTS; ++bit) {
+                if (signature.test(bit)) {
+                    m_SystemsByComponent[bit].push_back(id);
+                }
+            }
         }
 
-        void EntityDestroyed(Entity entity) {
-            for (auto const& pair : m_Systems) {
-                pair.second->m_Entities.erase(entity);
+        void EntityDestroyed(Entity entity, Signature entitySignature) {
+            for (SystemTypeID id : m_UniversalSystems) {
+                m_Systems[id]->m_Entities.Erase(entity);
+            }
+            for (ComponentTypeID bit = 0; bit < MAX_COMPONENTS; ++bit) {
+                if (!entitySignature.test(bit)) continue;
+                for (SystemTypeID id : m_SystemsByComponent[bit]) {
+                    m_Systems[id]->m_Entities.Erase(entity);
+                }
             }
         }
 
-        void EntitySignatureChanged(Entity entity, Signature entitySignature) {
-            for (auto const& pair : m_Systems) {
-                auto const& type = pair.first;
-                auto const& system = pair.second;
-                if (m_Signatures.find(type) == m_Signatures.end()) continue;
-                auto const& systemSignature = m_Signatures.at(type);
+        //only systems that care about the changed component can gain or lose the entity
+        void EntitySignatureChanged(Entity entity, Signature entitySignature, ComponentTypeID changedComponent) {
+            for (SystemTypeID id : m_UniversalSystems) {
+                m_Systems[id]->m_Entities.Insert(entity);
+            }
+            for (SystemTypeID id : m_SystemsByComponent[changedComponent]) {
+                auto const& systemSignature = m_Signatures[id];
                 if ((entitySignature & systemSignature) == systemSignature) {
-                    system->m_Entities.insert(entity);
+                    m_Systems[id]->m_Entities.Insert(entity);
                 }
                 else {
-                    system->m_Entities.erase(entity);
+                    m_Systems[id]->m_Entities.Erase(entity);
+                }
+            }
+        }
+
+        //a batch sharing one signature is matched against each system once
+        void EntitiesSpawned(const std::vector<Entity>& entities, Signature signature) {
+            for (SystemTypeID id = 0; id < MAX_SYSTEMS; ++id) {
+                if (!m_HasSignature.test(id)) continue;
+                auto const& systemSignature = m_Signatures[id];
+                if ((signature & systemSignature) != systemSignature) continue;
+                for (Entity entity : entities) {
+                    m_Systems[id]->m_Entities.Insert(entity);
                 }
             }
         }
 
         void Reset() {
-            for (auto const& pair : m_Systems) {
-                pair.second->m_Entities.clear();
+            for (auto const& system : m_Systems) {
+                if (system) {
+                    system->m_Entities.Clear();
+                }
             }
         }
 
     private:
-        std::unordered_map<const char*, Signature> m_Signatures{};
-        std::unordered_map<const char*, std::shared_ptr<System>> m_Systems{};
+        std::array<Signature, MAX_SYSTEMS> m_Signatures{};
+        std::bitset<MAX_SYSTEMS> m_HasSignature{};
+        std::array<std::shared_ptr<System>, MAX_SYSTEMS> m_Systems{};
+        std::array<std::vector<SystemTypeID>, MAX_COMPONENTS> m_SystemsByComponent{};
+        std::vector<SystemTypeID> m_UniversalSystems{};
     };
 
 
@@ -313,13 +785,18 @@ namespace ecs {
 
         Entity CreateEntity() { return m_EntityManager->CreateEntity(); }
         Entity CreateEntity(Entity id) { return m_EntityManager->CreateEntity(id); } // <-- NEW
+        void CreateEntities(const std::vector<Entity>& ids) { m_EntityManager->CreateEntities(ids); }
         void DestroyEntity(Entity entity) {
+            Signature signature = m_EntityManager->GetSignature(entity);
             m_EntityManager->DestroyEntity(entity);
-            m_ComponentManager->EntityDestroyed(entity);
-            m_SystemManager->EntityDestroyed(entity);
+            m_ComponentManager->EntityDestroyed(entity, signature);
+            m_SystemManager->EntityDestroyed(entity, signature);
         }
+        bool IsAlive(Entity entity) const { return m_EntityManager->IsAlive(entity); }
         uint32_t GetLivingEntityCount() const { return m_EntityManager->GetLivingEntityCount(); }
-        const std::set<Entity>& GetLivingEntities() const { return m_EntityManager->GetLivingEntities(); } // <-- NEW
+        const std::vector<Entity>& GetLivingEntities() const { return m_EntityManager->GetLivingEntities(); } // <-- NEW
+        size_t GetEntityMemoryUsage() const { return m_EntityManager->GetMemoryUsage(); }
+        size_t GetComponentMemoryUsage() const { return m_ComponentManager->GetMemoryUsage(); }
 
         void Reset() {
             m_EntityManager->Reset();
@@ -327,6 +804,28 @@ namespace ecs {
             m_SystemManager->Reset();
         }
 
+        //creates count entities from the prefab, then calls initializer(entity, i) to fill per-instance values
+        template<typename Initializer>
+        std::vector<Entity> Spawn(const Prefab& prefab, size_t count, Initializer initializer) {
+            std::vector<Entity> entities;
+            entities.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                Entity entity = m_EntityManager->CreateEntity();
+                m_EntityManager->SetSignature(entity, prefab.GetSignature());
+                entities.push_back(entity);
+            }
+            prefab.Insert(*m_ComponentManager, entities);
+            m_SystemManager->EntitiesSpawned(entities, prefab.GetSignature());
+            for (size_t i = 0; i < count; ++i) {
+                initializer(entities[i], i);
+            }
+            return entities;
+        }
+
+        std::vector<Entity> Spawn(const Prefab& prefab, size_t count = 1) {
+            return Spawn(prefab, count, [](Entity, size_t) {});
+        }
+
         template<typename T>
         void RegisterComponent() { m_ComponentManager->RegisterComponent<T>(); }
         template<typename T>
@@ -335,7 +834,7 @@ namespace ecs {
             auto signature = m_EntityManager->GetSignature(entity);
             signature.set(m_ComponentManager->GetComponentTypeID<T>(), true);
             m_EntityManager->SetSignature(entity, signature);
-            m_SystemManager->EntitySignatureChanged(entity, signature);
+            m_SystemManager->EntitySignatureChanged(entity, signature, ComponentType<T>());
         }
         template<typename T>
         void RemoveComponent(Entity entity) {
@@ -343,7 +842,7 @@ namespace ecs {
             auto signature = m_EntityManager->GetSignature(entity);
             signature.set(m_ComponentManager->GetComponentTypeID<T>(), false);
             m_EntityManager->SetSignature(entity, signature);
-            m_SystemManager->EntitySignatureChanged(entity, signature);
+            m_SystemManager->EntitySignatureChanged(entity, signature, ComponentType<T>());
         }
         template<typename T>
         T& GetComponent(Entity entity) { return m_ComponentManager->GetComponent<T>(entity); }
@@ -352,10 +851,20 @@ namespace ecs {
         template<typename T>
         ComponentTypeID GetComponentTypeID() const { return m_ComponentManager->GetComponentTypeID<T>(); }
 
+        template<typename... Include>
+        ComponentView<TypeList<Include...>> View() {
+            return { { m_ComponentManager->GetComponentArray<Include>()... }, {} };
+        }
+        template<typename... Include, typename... Excluded>
+        ComponentView<TypeList<Include...>, TypeList<Excluded...>> View(TypeList<Excluded...>) {
+            return { { m_ComponentManager->GetComponentArray<Include>()... },
+                     { m_ComponentManager->GetComponentArray<Excluded>()... } };
+        }
+
         template<typename T>
         std::shared_ptr<T> RegisterSystem() { return m_SystemManager->RegisterSystem<T>(this); }
         template<typename T>
-        std::shared_ptr<T> GetSystem() const { return m_SystemManager->GetSystem<T>(); }
+        T* GetSystem() const { return m_SystemManager->GetSystem<T>(); }
         template<typename T>
         void SetSystemSignature(Signature signature) { m_SystemManager->SetSignature<T>(signature); }
 
@@ -365,4 +874,83 @@ namespace ecs {
         std::unique_ptr<SystemManager> m_SystemManager;
     };
 
+
+    template<typename T>
+    void CommandBuffer::AddComponent(Entity entity, T component) {
+        PushComponentCommand(entity, ComponentType<T>(), [component](Registry& registry, Entity target) {
+            if (registry.HasComponent<T>(target)) {
+                registry.GetComponent<T>(target) = component;
+            }
+            else {
+                registry.AddComponent<T>(target, component);
+            }
+        });
+    }
+
+    template<typename T>
+    void CommandBuffer::RemoveComponent(Entity entity) {
+        PushComponentCommand(entity, ComponentType<T>(), [](Registry& registry, Entity target) {
+            if (registry.HasComponent<T>(target)) {
+                registry.RemoveComponent<T>(target);
+            }
+        });
+    }
+
+    //creates go first (one Spawn batch per prefab) so later commands can refer to the new entities,
+    //then component changes grouped by type, then destroys. commands aimed at dead entities or at entities
+    //destroyed in this same buffer are dropped
+    inline void CommandBuffer::Playback(Registry& registry) {
+        if (Empty()) return;
+
+        std::vector<Entity> created(m_Creates.size(), NULL_ENTITY);
+        std::vector<const Prefab*> prefabs;
+        for (auto const& command : m_Creates) {
+            if (command.prefab && std::find(prefabs.begin(), prefabs.end(), command.prefab) == prefabs.end()) {
+                prefabs.push_back(command.prefab);
+            }
+        }
+        for (const Prefab* prefab : prefabs) {
+            size_t count = 0;
+            for (auto const& command : m_Creates) count += command.prefab == prefab;
+            std::vector<Entity> entities = registry.Spawn(*prefab, count);
+            size_t next = 0;
+            for (size_t i = 0; i < m_Creates.size(); ++i) {
+                if (m_Creates[i].prefab == prefab) created[i] = entities[next++];
+            }
+        }
+        for (size_t i = 0; i < m_Creates.size(); ++i) {
+            if (!m_Creates[i].prefab) created[i] = registry.CreateEntity();
+        }
+        for (size_t i = 0; i < m_Creates.size(); ++i) {
+            if (m_Creates[i].initializer) m_Creates[i].initializer(registry, created[i]);
+        }
+
+        auto resolve = [&created](Entity entity) {
+            return IsTemporaryEntity(entity) ? created[GetEntityIndex(entity)] : entity;
+        };
+
+        for (Entity& entity : m_Destroys) entity = resolve(entity);
+        std::sort(m_Destroys.begin(), m_Destroys.end());
+        m_Destroys.erase(std::unique(m_Destroys.begin(), m_Destroys.end()), m_Destroys.end());
+
+        for (auto& command : m_ComponentCommands) command.entity = resolve(command.entity);
+        std::stable_sort(m_ComponentCommands.begin(), m_ComponentCommands.end(),
+            [](const ComponentCommand& a, const ComponentCommand& b) {
+                return a.type != b.type ? a.type < b.type : a.entity < b.entity;
+            });
+        for (auto const& command : m_ComponentCommands) {
+            if (!registry.IsAlive(command.entity)) continue;
+            if (std::binary_search(m_Destroys.begin(), m_Destroys.end(), command.entity)) continue;
+            command.apply(registry, command.entity);
+        }
+
+        for (Entity entity : m_Destroys) {
+            if (registry.IsAlive(entity)) registry.DestroyEntity(entity);
+        }
+
+        m_Creates.clear();
+        m_Destroys.clear();
+        m_ComponentCommands.clear();
+    }
+
 }
\ No newline at end of file
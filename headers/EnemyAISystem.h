@@ -4,81 +4,449 @@
 #include "Components.h"
 #include "GridSystem.h"
 #include "Pathfinder.h"
+#include "FlowField.h"
+#include "HierarchicalPathfinder.h"
+#include "PathRequestService.h"
+#include "PathIndex.h"
+#include "PathCache.h"
+#include "BuildingIndex.h"
+#include "Scheduler.h"
 #include <glm/glm.hpp>
 #include <optional>
+#include <algorithm>
 #include <iostream> 
 #include <random> 
+#include <chrono>
+
+//FlowField: one field towards the nearest building, rebuilt when grid occupancy changes, every enemy reads its tile.
+//AStar: the old per-enemy search against the closest building, redone for idle enemies on the repath timer
+//Hierarchical: same targeting as AStar, but the search runs on the HPA* cluster graph and each leg is expanded to
+//tiles only when the enemy finishes the previous one
+enum class PathingMode {
+    FlowField,
+    AStar,
+    Hierarchical
+};
 
 class EnemyAISystem : public ecs::System {
 public:
-    void Init(GridSystem* gridSystem) {
+    static constexpr int UPDATE_HISTORY = 200; //ticks of AI cost kept for the debug window
+
+    void Init(GridSystem* gridSystem, JobSystem* jobs) {
         m_GridSystem = gridSystem;
+        m_PathRequests.Init(jobs);
+        m_PathIndex.Clear();
+        m_PathCache.Clear();
+        m_PathPool.Init(gridSystem);
+        m_Buildings.Clear();
+        m_NextBucket = 0;
+        m_BucketTimer = 0.0f;
+        m_SeenOccupancyVersion = gridSystem->GetOccupancyVersion();
         m_RandomEngine.seed(std::random_device()());
+        m_FlowField = FlowField();
+        m_Hierarchy = HierarchicalPathfinder();
     }
 
-    void Update(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allRenderableEntities) {
+    //paths, coarse routes and queued searches from the old mode mean nothing to the new one, so every enemy starts
+    //over at the top of the next update
+    void SetPathingMode(PathingMode mode) {
+        if (mode == m_PathingMode) return;
+        m_PathCache.Clear(); //A* and HPA* answers look different
+        m_PathingMode = mode;
+        m_PathingModeChanged = true;
+    }
+    void SetSmoothPaths(bool smooth) {
+        if (smooth != m_SmoothPaths) m_PathCache.Clear();
+        m_SmoothPaths = smooth;
+    }
+    bool GetSmoothPaths() const { return m_SmoothPaths; }
+    PathingMode GetPathingMode() const { return m_PathingMode; }
+    const FlowField& GetFlowField() const { return m_FlowField; }
+    size_t GetFlowFieldBuilds() const { return m_FlowFieldBuilds; }
+    double GetLastFlowFieldBuildMs() const { return m_LastFlowFieldBuildMs; }
+    const HierarchicalPathfinder& GetHierarchy() const { return m_Hierarchy; }
+    double GetLastHierarchyUpdateMs() const { return m_LastHierarchyUpdateMs; }
+    PathRequestService& GetPathRequests() { return m_PathRequests; }
+    PathCache& GetPathCache() { return m_PathCache; }
+    const PathPool& GetPathPool() const { return m_PathPool; }
+    size_t GetPathRepairs() const { return m_PathRepairs; }
+    size_t GetPathRepairFallbacks() const { return m_PathRepairFallbacks; }
+    double GetLastRepairMs() const { return m_LastRepairMs; }
+    size_t GetPathIndexEntries() const { return m_PathIndex.GetEntryCount(); }
+    const BuildingIndex& GetBuildingIndex() const { return m_Buildings; }
 
-        m_AiRepathTimer -= dt;
-        bool doRepath = (m_AiRepathTimer <= 0.0f);
-        if (doRepath) {
-            m_AiRepathTimer = 1.0f;
-        }
+    //idle enemies look for a target once per REPATH_INTERVAL, but not all in the same tick: each one's phase is its
+    //entity id modulo the bucket count, and the buckets take turns spread evenly over the interval. 1 bucket is the
+    //old behaviour of everyone at once
+    void SetAiBuckets(int buckets) {
+        m_AiBuckets = std::max(1, buckets);
+        m_NextBucket %= m_AiBuckets;
+    }
+    int GetAiBuckets() const { return m_AiBuckets; }
+    double GetLastUpdateMs() const { return m_UpdateMs[(m_UpdateMsCursor + UPDATE_HISTORY - 1) % UPDATE_HISTORY]; }
+    double GetPeakUpdateMs() const { return *std::max_element(m_UpdateMs, m_UpdateMs + UPDATE_HISTORY); }
+    const float* GetUpdateHistory() const { return m_UpdateMs; }
+    int GetUpdateHistoryOffset() const { return m_UpdateMsCursor; }
+    size_t GetLastAcquisitions() const { return m_LastAcquisitions; }
 
-        std::vector<ecs::Entity> targets;
-        for (auto const& entity : allRenderableEntities) {
-            if (registry->HasComponent<BuildingComponent>(entity)) {
-                targets.push_back(entity);
-            }
+    void Update(float dt, ecs::Registry* registry) {
+        auto start = std::chrono::steady_clock::now();
+        UpdateEnemies(dt, registry);
+        m_UpdateMs[m_UpdateMsCursor] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_UpdateMsCursor = (m_UpdateMsCursor + 1) % UPDATE_HISTORY;
+    }
+
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess()
+            .Read<EnemyComponent, BuildingComponent, TransformComponent>()
+            .Write<MovementComponent>()
+            .ReadResource<GridSystem>()
+            .WriteResource<PathPool>();
+    }
+
+private:
+    static constexpr float REPATH_INTERVAL = 1.0f; //seconds between target searches for any one idle enemy
+
+    GridSystem* m_GridSystem;
+    std::mt19937 m_RandomEngine;
+
+    PathingMode m_PathingMode = PathingMode::AStar; //what the game always did, the flow field and HPA* are picked in the debug window
+    bool m_PathingModeChanged = false;
+    bool m_SmoothPaths = true; //string-pull A* and HPA* paths so enemies walk straight lines instead of tile to tile
+    FlowField m_FlowField;
+    size_t m_FlowFieldBuilds = 0;
+    double m_LastFlowFieldBuildMs = 0.0;
+
+    HierarchicalPathfinder m_Hierarchy;
+    double m_LastHierarchyUpdateMs = 0.0;
+
+    PathRequestService m_PathRequests;
+    PathCache m_PathCache;
+    PathPool m_PathPool;
+    BuildingIndex m_Buildings;
+
+    PathIndex m_PathIndex;
+    uint32_t m_SeenOccupancyVersion = 0;
+    std::vector<ecs::Entity> m_RepairAffected; //repair scratch, kept between ticks for the capacity
+    std::vector<glm::ivec2> m_RepairPath;
+    std::vector<glm::ivec2> m_RepairSpliced;
+    std::vector<glm::vec3> m_RepairDetour;
+    size_t m_PathRepairs = 0;
+    size_t m_PathRepairFallbacks = 0;
+    double m_LastRepairMs = 0.0;
+
+    int m_AiBuckets = 100;        //one bucket per 10ms tick, so a steady 1/100 of the idle enemies per tick
+    int m_NextBucket = 0;
+    float m_BucketTimer = 0.0f;   //time not yet handed out to buckets
+    size_t m_LastAcquisitions = 0;
+    float m_UpdateMs[UPDATE_HISTORY] = {}; //ring of whole-Update costs, m_UpdateMsCursor is the oldest
+    int m_UpdateMsCursor = 0;
+
+    void UpdateEnemies(float dt, ecs::Registry* registry) {
+        if (m_PathingModeChanged) ResetEnemyPaths(registry);
+        if (m_PathPool.NeedsCollect()) CollectPaths(registry);
+
+        //buckets [m_NextBucket, m_NextBucket + dueBuckets) wrapping around are due this tick
+        m_BucketTimer += dt;
+        float bucketInterval = REPATH_INTERVAL / m_AiBuckets;
+        int dueBuckets = std::min(m_AiBuckets, static_cast<int>(m_BucketTimer / bucketInterval + 1e-3f));
+        m_BucketTimer = std::clamp(m_BucketTimer - dueBuckets * bucketInterval, 0.0f, bucketInterval); //a long stall doesn't owe buckets
+        int firstBucket = m_NextBucket;
+        m_NextBucket = (m_NextBucket + dueBuckets) % m_AiBuckets;
+        auto isDue = [&](ecs::Entity entity) {
+            int phase = static_cast<int>(entity % static_cast<ecs::Entity>(m_AiBuckets));
+            return (phase - firstBucket + m_AiBuckets) % m_AiBuckets < dueBuckets;
+        };
+        m_LastAcquisitions = 0;
+
+        m_Buildings.Sync(*m_GridSystem, *registry);
+        if (m_Buildings.Empty()) return;
+
+        if (m_PathingMode == PathingMode::FlowField) {
+            SteerByFlowField(registry);
+            return;
+        }
+        if (m_PathingMode == PathingMode::Hierarchical && !m_Hierarchy.IsCurrent(*m_GridSystem)) {
+            auto start = std::chrono::steady_clock::now();
+            m_Hierarchy.Update(*m_GridSystem);
+            m_LastHierarchyUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
-        if (targets.empty()) return;
 
-        for (auto const& entity : m_Entities) {
-            auto& transform = m_Registry->GetComponent<TransformComponent>(entity);
-            auto& movement = m_Registry->GetComponent<MovementComponent>(entity);
+        RepairPaths(registry);
 
-            if (movement.targetEntity != ecs::MAX_ENTITIES && !registry->HasComponent<HealthComponent>(movement.targetEntity)) {
-                movement.targetEntity = ecs::MAX_ENTITIES;
+        //searches asked for on earlier ticks, within this tick's budget
+        bool hierarchical = m_PathingMode == PathingMode::Hierarchical;
+        m_PathRequests.Process([&](glm::ivec2 start, glm::ivec2 goal, PathResult& result) {
+            if (hierarchical) result.coarsePath = m_Hierarchy.FindAbstractPath(*m_GridSystem, start, goal);
+            else FindSmoothedPath(start, goal, result.path);
+        }, !hierarchical, [&](glm::ivec2 start, glm::ivec2 goal, const std::shared_ptr<const PathResult>& result) {
+            m_PathCache.Store(start, goal, m_GridSystem->GetOccupancyVersion(), result);
+        }, [&](ecs::Entity entity, const PathResult& result) {
+            DeliverPath(registry, entity, result);
+        });
+
+        registry->View<EnemyComponent, MovementComponent, TransformComponent>().Each([&](ecs::Entity entity, EnemyComponent&, MovementComponent& movement, TransformComponent& transform) {
+            if (movement.targetEntity != ecs::NULL_ENTITY && !registry->IsAlive(movement.targetEntity)) {
+                movement.targetEntity = ecs::NULL_ENTITY;
                 movement.isAttacking = false;
-                movement.path.clear();
+                movement.path.Clear();
+                movement.coarsePath.Clear();
+                m_PathRequests.Cancel(entity);
             }
 
-            bool isIdle = movement.path.empty() || movement.currentPathIndex >= movement.path.size();
+            bool isIdle = movement.path.Empty() || movement.currentPathIndex >= movement.path.Size();
+
+            if (m_PathingMode == PathingMode::Hierarchical && isIdle && movement.targetEntity != ecs::NULL_ENTITY &&
+                movement.coarsePathIndex < (int)movement.coarsePath.Size()) {
+                RefineNextLeg(entity, movement, transform);
+                return;
+            }
 
             //if idle try to find new closest target
-            if (movement.targetEntity == ecs::MAX_ENTITIES && isIdle && doRepath)
+            if (movement.targetEntity == ecs::NULL_ENTITY && isIdle && isDue(entity))
             {
+                ++m_LastAcquisitions;
                 //pillaging logic
-                ecs::Entity closestTarget = targets[0];
-                float minDistance = FLT_MAX;
-
-                for (auto const& targetEntity : targets) {
-                    auto& targetTransform = registry->GetComponent<TransformComponent>(targetEntity);
-                    float dist = glm::distance(transform.position, targetTransform.position);
-                    if (dist < minDistance) {
-                        minDistance = dist;
-                        closestTarget = targetEntity;
-                    }
-                }
+                BuildingIndex::Nearest nearest = m_Buildings.FindNearest(transform.position);
+                ecs::Entity closestTarget = nearest.entity;
                 movement.targetEntity = closestTarget; 
+                movement.path.Clear();
+                movement.coarsePath.Clear();
 
+                //a search someone already did on this grid is answered right away, anything else arrives on a later
+                //tick with the front of the wave served first
                 glm::ivec2 startTile = m_GridSystem->WorldToGrid(transform.position);
                 glm::ivec2 endTile = m_GridSystem->WorldToGrid(registry->GetComponent<TransformComponent>(closestTarget).position);
-
-                movement.path = Pathfinder::FindPath(m_GridSystem, startTile, endTile);
-                movement.currentPathIndex = 0;
-
-                if (movement.path.empty()) {
-                    std::cout << "Enemy " << entity << " COULD NOT FIND PATH" << std::endl;
+                if (auto cached = m_PathCache.Find(startTile, endTile, m_GridSystem->GetOccupancyVersion())) {
+                    m_PathRequests.Cancel(entity);
+                    DeliverPath(registry, entity, *cached);
                 }
                 else {
-                    std::cout << "Enemy " << entity << " acquired new target " << closestTarget << "!" << std::endl;
+                    m_PathRequests.Submit(entity, startTile, endTile, -static_cast<int>(nearest.distance));
                 }
             }
+        });
+    }
+
+    void ResetEnemyPaths(ecs::Registry* registry) {
+        registry->View<EnemyComponent, MovementComponent>().Each([&](ecs::Entity entity, EnemyComponent&, MovementComponent& movement) {
+            movement.path.Clear();
+            movement.currentPathIndex = 0;
+            ++movement.pathStamp; //drops its path index entries
+            movement.coarsePath.Clear();
+            movement.coarsePathIndex = 0;
+            movement.targetEntity = ecs::NULL_ENTITY;
+            movement.isAttacking = false;
+            m_PathRequests.Cancel(entity);
+        });
+        m_PathIndex.Clear();
+        m_PathingModeChanged = false;
+    }
+
+    //the enemy may have picked another target or lost its own since it asked, then the answer is dropped
+    void DeliverPath(ecs::Registry* registry, ecs::Entity entity, const PathResult& result) {
+        if (!registry->IsAlive(entity) || !registry->HasComponent<MovementComponent>(entity)) return;
+        auto& movement = registry->GetComponent<MovementComponent>(entity);
+        if (movement.targetEntity == ecs::NULL_ENTITY || !registry->IsAlive(movement.targetEntity)) return;
+
+        movement.currentPathIndex = 0;
+        if (!result.coarsePath.empty()) {
+            if (!m_PathPool.IsLive(result.pooledCoarsePath)) result.pooledCoarsePath = m_PathPool.Store(result.coarsePath);
+            movement.coarsePath = result.pooledCoarsePath;
+            movement.coarsePathIndex = 1; //[0] is where the enemy stood when it asked
+            movement.path.Clear();
+            RefineNextLeg(entity, movement, registry->GetComponent<TransformComponent>(entity));
+        }
+        else if (!result.path.empty()) {
+            movement.coarsePath.Clear();
+            if (!m_PathPool.IsLive(result.pooledPath)) result.pooledPath = m_PathPool.Store(result.path);
+            SetPath(entity, movement, result.pooledPath);
+        }
+        else {
+            std::cout << "Enemy " << entity << " COULD NOT FIND PATH" << std::endl;
+            movement.targetEntity = ecs::NULL_ENTITY; //try again on the next repath
+            return;
+        }
+        if (!movement.path.Empty()) {
+            std::cout << "Enemy " << entity << " acquired new target " << movement.targetEntity << "!" << std::endl;
         }
     }
 
-private:
-    GridSystem* m_GridSystem;
-    std::mt19937 m_RandomEngine;
-    float m_AiRepathTimer = 0.0f;
+    //tells the path index which of its entries still belong to the entity's current path
+    auto IsCurrentPath() const {
+        return [this](ecs::Entity entity, uint32_t stamp) {
+            return m_Registry->IsAlive(entity) && m_Registry->HasComponent<MovementComponent>(entity) &&
+                m_Registry->GetComponent<MovementComponent>(entity).pathStamp == stamp;
+        };
+    }
+
+    void RefineNextLeg(ecs::Entity entity, MovementComponent& movement, const TransformComponent& transform) {
+        glm::ivec2 from = m_GridSystem->WorldToGrid(transform.position);
+        glm::ivec2 to = m_PathPool.GetTile(movement.coarsePath, movement.coarsePathIndex++);
+        bool isLastLeg = movement.coarsePathIndex >= (int)movement.coarsePath.Size();
+        std::vector<glm::vec3> leg;
+        if (isLastLeg || m_GridSystem->IsWalkable(to.x, to.y)) { //a built-over entrance means the whole route is stale
+            leg = m_Hierarchy.RefineSegment(*m_GridSystem, from, to);
+            if (m_SmoothPaths) Pathfinder::SmoothPath(m_GridSystem, leg);
+        }
+        SetPath(entity, movement, m_PathPool.Store(leg));
+        if (movement.path.Empty()) {
+            //the route went stale, drop the target so the next repath picks a fresh one
+            movement.coarsePath.Clear();
+            movement.coarsePathIndex = 0;
+            movement.targetEntity = ecs::NULL_ENTITY;
+        }
+    }
+
+    //every path that can be repaired goes through here so the tile index knows about it
+    void SetPath(ecs::Entity entity, MovementComponent& movement, PathHandle path) {
+        movement.path = path;
+        movement.currentPathIndex = 0;
+        ++movement.pathStamp;
+        m_PathIndex.Register(entity, movement.pathStamp, *m_GridSystem, m_PathPool, movement.path, IsCurrentPath());
+    }
+
+    //pooled paths nobody holds any more are freed and the arena is compacted
+    void CollectPaths(ecs::Registry* registry) {
+        m_PathPool.Collect([&](auto mark) {
+            registry->View<MovementComponent>().Each([&](ecs::Entity, MovementComponent& movement) {
+                mark(movement.path);
+                mark(movement.coarsePath);
+            });
+        });
+    }
+
+    //newly occupied tiles are looked up in the path index, so paths that don't cross one cost nothing. a broken path
+    //keeps everything before and after the blocked stretch and only searches a detour around it; if there is none
+    //the enemy drops its target and repaths. freed tiles can't break a path and are ignored
+    void RepairPaths(ecs::Registry* registry) {
+        uint32_t version = m_GridSystem->GetOccupancyVersion();
+        if (version == m_SeenOccupancyVersion) return;
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<ecs::Entity>& affected = m_RepairAffected;
+        affected.clear();
+        bool upToDate = m_GridSystem->ForEachOccupancyChangeSince(m_SeenOccupancyVersion, [&](const OccupancyChange& change) {
+            if (!change.occupied) return;
+            m_PathIndex.ForEachOnTile(*m_GridSystem, change.tile, IsCurrentPath(), [&](ecs::Entity entity) {
+                affected.push_back(entity);
+            });
+        });
+        m_SeenOccupancyVersion = version;
+        if (!upToDate) {
+            //fell further behind than the grid keeps flips for, so every path is indexed again and checked in full
+            affected.clear();
+            m_PathIndex.Clear();
+            registry->View<EnemyComponent, MovementComponent>().Each([&](ecs::Entity entity, EnemyComponent&, MovementComponent& movement) {
+                if (movement.path.Empty()) return;
+                ++movement.pathStamp;
+                m_PathIndex.Register(entity, movement.pathStamp, *m_GridSystem, m_PathPool, movement.path, IsCurrentPath());
+                affected.push_back(entity);
+            });
+        }
+
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        for (ecs::Entity entity : affected) {
+            RepairPath(entity, registry->GetComponent<MovementComponent>(entity), registry->GetComponent<TransformComponent>(entity));
+        }
+        m_LastRepairMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void RepairPath(ecs::Entity entity, MovementComponent& movement, const TransformComponent& transform) {
+        std::vector<glm::ivec2>& path = m_RepairPath;
+        path.clear();
+        for (size_t i = movement.currentPathIndex; i < movement.path.Size(); ++i) {
+            path.push_back(m_PathPool.GetTile(movement.path, i));
+        }
+        glm::ivec2 position = m_GridSystem->WorldToGrid(transform.position);
+        auto walkable = [&](size_t i) { return m_GridSystem->IsWalkable(path[i].x, path[i].y); };
+        //smoothed waypoints can be several tiles apart, so what breaks is the straight line into a waypoint. the last
+        //waypoint is the building being attacked, that one is supposed to be occupied
+        auto reachable = [&](size_t i) {
+            return m_GridSystem->IsLineWalkable(i > 0 ? path[i - 1] : position, path[i], i + 1 == path.size());
+        };
+
+        //a path can run into the same wall more than once, so keep splicing until no blocked stretch is left
+        bool repaired = false;
+        size_t blocked = 0;
+        while (true) {
+            while (blocked < path.size() && reachable(blocked)) ++blocked;
+            if (blocked >= path.size()) break;
+            size_t resume = blocked;
+            while (resume + 1 < path.size() && !walkable(resume)) ++resume;
+
+            glm::ivec2 from = blocked > 0 ? path[blocked - 1] : position;
+            std::vector<glm::vec3>& detour = m_RepairDetour;
+            FindSmoothedPath(from, path[resume], detour);
+            if (detour.empty()) {
+                movement.path.Clear();
+                movement.coarsePath.Clear();
+                movement.targetEntity = ecs::NULL_ENTITY;
+                ++m_PathRepairFallbacks;
+                return;
+            }
+
+            size_t kept = blocked > 0 ? blocked - 1 : 0;
+            std::vector<glm::ivec2>& spliced = m_RepairSpliced;
+            spliced.assign(path.begin(), path.begin() + kept);
+            for (auto const& waypoint : detour) spliced.push_back(m_GridSystem->WorldToGrid(waypoint));
+            spliced.insert(spliced.end(), path.begin() + resume + 1, path.end());
+            path.swap(spliced); //both buffers keep their capacity for the next repair
+            blocked = kept + detour.size();
+            repaired = true;
+        }
+        if (!repaired) return;
+        SetPath(entity, movement, m_PathPool.Store(path));
+        ++m_PathRepairs;
+    }
+
+    //written over `path`; the request queue passes a recycled result's buffer, repairs pass their scratch one
+    void FindSmoothedPath(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::vec3>& path) const {
+        Pathfinder::FindPath(m_GridSystem, start, goal, path);
+        if (m_SmoothPaths) Pathfinder::SmoothPath(m_GridSystem, path);
+    }
+
+    //every tick each enemy gets a single waypoint: the center of the next tile down the field, or the building's
+    //own tile once it is next to it so MovementSystem can walk into attack range. the one-tile path is only stored
+    //again when the tile changes
+    void SteerByFlowField(ecs::Registry* registry) {
+        if (!m_FlowField.IsCurrent(*m_GridSystem)) {
+            auto start = std::chrono::steady_clock::now();
+            m_FlowField.Build(*m_GridSystem);
+            m_LastFlowFieldBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            ++m_FlowFieldBuilds;
+        }
+
+        registry->View<EnemyComponent, MovementComponent, TransformComponent>().Each([&](ecs::Entity, EnemyComponent&, MovementComponent& movement, TransformComponent& transform) {
+            if (movement.targetEntity != ecs::NULL_ENTITY && !registry->IsAlive(movement.targetEntity)) {
+                movement.targetEntity = ecs::NULL_ENTITY;
+                movement.isAttacking = false;
+                movement.path.Clear();
+            }
+            if (movement.isAttacking) return;
+
+            glm::ivec2 tile = m_GridSystem->WorldToGrid(transform.position);
+            ecs::Entity source = m_FlowField.GetSource(tile.x, tile.y);
+            if (source == ecs::NULL_ENTITY || !registry->IsAlive(source)) {
+                movement.targetEntity = ecs::NULL_ENTITY; //walled off, wait for the field to change
+                movement.path.Clear();
+                return;
+            }
+            movement.targetEntity = source;
+
+            glm::ivec2 waypoint;
+            auto next = m_FlowField.GetNextTile(tile.x, tile.y);
+            if (next && m_FlowField.GetCost(next->x, next->y) > 0) {
+                waypoint = *next;
+            }
+            else {
+                waypoint = m_GridSystem->WorldToGrid(registry->GetComponent<TransformComponent>(source).position);
+            }
+            if (movement.path.Size() != 1 || !m_PathPool.IsLive(movement.path) || m_PathPool.GetTile(movement.path, 0) != waypoint) {
+                movement.path = m_PathPool.Store(waypoint);
+            }
+            movement.currentPathIndex = 0;
+        });
+    }
 };
\ No newline at end of file
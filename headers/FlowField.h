@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ECS.h"
+#include "GridSystem.h"
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+//distance-to-nearest-building over the whole grid, built with one multi-source BFS seeded from every occupied tile.
+//every reachable free tile stores the step towards its BFS parent and the building its search started from, so an
+//enemy only has to look up its own tile to know where to go next. moves are 4-way with unit cost, same as Pathfinder
+class FlowField {
+public:
+    static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+    void Build(const GridSystem& grid) {
+        m_Width = grid.GetWidth();
+        m_Height = grid.GetHeight();
+        size_t tileCount = static_cast<size_t>(m_Width) * static_cast<size_t>(m_Height);
+        m_Cost.assign(tileCount, UNREACHABLE);
+        m_Direction.assign(tileCount, NO_DIRECTION);
+        m_Source.assign(tileCount, ecs::NULL_ENTITY);
+        m_Frontier.clear();
+
+        //row-major seeding keeps ties between equally close buildings deterministic
+        for (int y = 0; y < m_Height; ++y) {
+            for (int x = 0; x < m_Width; ++x) {
+                if (!grid.IsTileOccupied(x, y)) continue;
+                int index = TileIndex(x, y);
+                m_Cost[index] = 0;
+                m_Source[index] = grid.GetEntityAt(x, y);
+                m_Frontier.push_back(index);
+            }
+        }
+
+        for (size_t head = 0; head < m_Frontier.size(); ++head) {
+            int index = m_Frontier[head];
+            int x = index % m_Width;
+            int y = index / m_Width;
+            for (uint8_t dir = 0; dir < 4; ++dir) {
+                int nx = x + STEP_X[dir];
+                int ny = y + STEP_Y[dir];
+                if (!grid.IsWalkable(nx, ny)) continue;
+                int next = TileIndex(nx, ny);
+                if (m_Cost[next] != UNREACHABLE) continue;
+                m_Cost[next] = m_Cost[index] + 1;
+                m_Direction[next] = Opposite(dir);
+                m_Source[next] = m_Source[index];
+                m_Frontier.push_back(next);
+            }
+        }
+        m_Version = grid.GetOccupancyVersion();
+        m_Built = true;
+    }
+
+    bool IsCurrent(const GridSystem& grid) const {
+        return m_Built && m_Version == grid.GetOccupancyVersion() && m_Width == grid.GetWidth() && m_Height == grid.GetHeight();
+    }
+
+    //steps to the nearest building, 0 on a building tile, UNREACHABLE when walled off or off the map
+    uint32_t GetCost(int x, int y) const {
+        if (!IsValid(x, y)) return UNREACHABLE;
+        return m_Cost[TileIndex(x, y)];
+    }
+
+    //the neighbouring tile one step closer to the nearest building
+    std::optional<glm::ivec2> GetNextTile(int x, int y) const {
+        if (!IsValid(x, y)) return std::nullopt;
+        uint8_t dir = m_Direction[TileIndex(x, y)];
+        if (dir == NO_DIRECTION) return std::nullopt;
+        return glm::ivec2(x + STEP_X[dir], y + STEP_Y[dir]);
+    }
+
+    //building the tile's flow ends at
+    ecs::Entity GetSource(int x, int y) const {
+        if (!IsValid(x, y)) return ecs::NULL_ENTITY;
+        return m_Source[TileIndex(x, y)];
+    }
+
+    size_t GetMemoryUsage() const {
+        return m_Cost.capacity() * sizeof(uint32_t) + m_Direction.capacity() * sizeof(uint8_t) +
+            m_Source.capacity() * sizeof(ecs::Entity) + m_Frontier.capacity() * sizeof(int);
+    }
+
+private:
+    static constexpr uint8_t NO_DIRECTION = 0xFF;
+    static constexpr int STEP_X[4] = { 0, 0, 1, -1 };
+    static constexpr int STEP_Y[4] = { 1, -1, 0, 0 };
+
+    int m_Width = 0;
+    int m_Height = 0;
+    uint32_t m_Version = 0;
+    bool m_Built = false;
+    std::vector<uint32_t> m_Cost;        //integration field
+    std::vector<uint8_t> m_Direction;    //index into STEP_X/STEP_Y, NO_DIRECTION on buildings and unreachable tiles
+    std::vector<ecs::Entity> m_Source;
+    std::vector<int> m_Frontier;         //BFS queue, kept around so rebuilds don't reallocate
+
+    static uint8_t Opposite(uint8_t dir) { return dir ^ 1; }
+
+    bool IsValid(int x, int y) const { return x >= 0 && x < m_Width && y >= 0 && y < m_Height && m_Built; }
+    int TileIndex(int x, int y) const { return y * m_Width + x; }
+};
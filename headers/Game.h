@@ -9,7 +9,8 @@
 #include "OrbitCamera.h"
 #include "FlyCamera.h"
 
-namespace ecs { class Registry; }
+namespace ecs { class Registry; class Scheduler; }
+class JobSystem;
 class RenderSystem;
 class UISystem;
 class InputSystem;
@@ -21,6 +22,43 @@ class CombatSystem;
 class BalanceSystem;
 class ProjectileSystem;
 class CollisionSystem;
+class SpatialHashSystem;
+
+struct PathfindingBenchmarkResult {
+    int mapSize;
+    size_t queries;
+    double avgMs;          //per query, one thread
+    double avgNodes;       //expanded per query
+    double parallelMs;     //whole batch split across the job system
+    double hpaBuildMs;     //cluster graph over the whole map
+    double hpaMs;          //per query: abstract search plus refining every leg
+    double hpaNodes;       //abstract nodes expanded per query
+    double avgWaypoints;   //per A* path, one per tile
+    double avgSmoothed;    //per A* path after string pulling
+    double smoothMs;       //per path
+    double rawLength;      //world units walked per A* path
+    double smoothedLength; //same paths after string pulling
+    double moveRawMs;      //MovementSystem tick with MAZE_MOVERS enemies walking the A* paths
+    double moveSmoothedMs; //same with the smoothed paths
+};
+
+//one timed ECS operation from RunEcsBenchmark
+struct EcsBenchmarkResult {
+    std::string name;
+    size_t count;  //entities (or ids) it ran over
+    double ms;     //whole operation
+};
+
+//the combat load scenario: per-tick cost of the real schedule over a crowded map
+struct LoadBenchmarkResult {
+    size_t enemies = 0;
+    size_t turrets = 0;
+    size_t projectiles = 0;  //at the start, bullets die as they hit or leave the map
+    int ticks = 0;
+    double avgTickMs = 0.0;
+    double maxTickMs = 0.0;
+    std::vector<std::pair<std::string, double>> systemMs; //scheduler entry -> average ms per tick
+};
 
 enum class AppState {
     MAIN_MENU,
@@ -58,6 +96,7 @@ public:
     void SetAppState(AppState newState);
 
     void SpawnEnemyAt(glm::vec3 position);
+    void SpawnEnemiesAt(glm::vec3 position, size_t count);
 
     AppState getCurrentState() {
         return m_CurrentState;
@@ -68,9 +107,26 @@ public:
     void LoadGame();
     void ClearWorld();
 
+    //clears the world and rebuilds it on a width x height tile map
+    void ResizeMap(int width, int height);
+    int GetMapWidth() const { return m_MapWidth; }
+    int GetMapHeight() const { return m_MapHeight; }
+    glm::vec3 GetEnemySpawnPoint() const; //center of the far corner tile
+
+    ecs::Scheduler* GetScheduler() const { return m_Scheduler.get(); }
+    JobSystem* GetJobSystem() const { return m_Jobs.get(); }
+    std::vector<std::pair<size_t, double>> RunJobScalingBenchmark(size_t entityCount, int ticks);
+    static constexpr size_t MAZE_MOVERS = 10000; //enemies spread over the benchmark paths for the movement run
+    std::vector<PathfindingBenchmarkResult> RunPathfindingBenchmark();
+    std::vector<EcsBenchmarkResult> RunEcsBenchmark();
+    //replaces the world with a 200x200 map holding the given load and runs the simulation schedule for `ticks` ticks
+    LoadBenchmarkResult RunCombatLoadBenchmark(size_t enemies, size_t turrets, size_t projectiles, int ticks);
+
 private:
     void Init();
     void ProcessInput(float dt);
+    void BuildSchedule();
+    void PlaybackCommands();
     
     void Render();
     void Cleanup();
@@ -78,6 +134,7 @@ private:
 
 
     int m_Width, m_Height;
+    int m_MapWidth, m_MapHeight;
     std::string m_Title;
     AppState m_CurrentState;
 
@@ -94,6 +151,10 @@ private:
     std::shared_ptr<CombatSystem> m_CombatSystem;
     std::shared_ptr<ProjectileSystem> m_ProjectileSystem;
     std::shared_ptr<CollisionSystem> m_CollisionSystem;
+    std::shared_ptr<SpatialHashSystem> m_SpatialHashSystem;
+
+    std::unique_ptr<JobSystem> m_Jobs;
+    std::unique_ptr<ecs::Scheduler> m_Scheduler;
 
     glm::vec3 m_BasePosition = { 0,0,0 };
 
@@ -2,57 +2,179 @@
 
 #include "ECS.h" 
 #include <vector>
+#include <cstdint>
+#include <cmath>
 #include <glm/glm.hpp>
 
-constexpr int GRID_WIDTH = 20;
-constexpr int GRID_HEIGHT = 20;
+//one tile flipping between free and occupied. entity is the new occupant, or the one that just left
+struct OccupancyChange {
+    glm::ivec2 tile;
+    bool occupied;
+    ecs::Entity entity;
+};
 
+//map dimensions are set at runtime by Init. tiles are one row-major array (index y * width + x) and occupancy is
+//mirrored in a bitset, so walkability checks over a 1024x1024 map touch 128KB instead of 4MB
 class GridSystem : public ecs::System {
 public:
-    void Init() {
-        m_Grid.resize(GRID_WIDTH, std::vector<ecs::Entity>(GRID_HEIGHT, ecs::MAX_ENTITIES));
+    //occupancy flips kept for consumers that haven't caught up yet. once the log holds twice this many, the oldest
+    //are dropped down to this many, so a lagging consumer takes its full-rebuild path instead of the log growing
+    //all session
+    static constexpr size_t OCCUPANCY_LOG_LIMIT = 4096;
+
+    void Init(int width, int height) {
+        m_Width = width;
+        m_Height = height;
+        size_t tileCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+        m_Tiles.assign(tileCount, ecs::NULL_ENTITY);
+        m_Occupied.assign((tileCount + 63) / 64, 0);
+        m_OccupancyLog.clear();
+        m_LogBaseVersion = ++m_OccupancyVersion;
+    }
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+
+    //bumped whenever a tile flips between free and occupied (or the map is re-initialized), so anything derived
+    //from occupancy can tell when it is stale
+    uint32_t GetOccupancyVersion() const { return m_OccupancyVersion; }
+
+    //occupancy events: calls func(const OccupancyChange&) for every flip after `version`, oldest first. consumers
+    //pull whenever they next run and remember the version they got to, so nobody is called back from inside
+    //SetEntityAt. returns false without calling anything when `version` is from before the last Init or older than
+    //the log still goes back (see OCCUPANCY_LOG_LIMIT), the caller has to rebuild from scratch then
+    template<typename Func>
+    bool ForEachOccupancyChangeSince(uint32_t version, Func func) const {
+        if (version < m_LogBaseVersion || version > m_OccupancyVersion) return false;
+        for (size_t i = version - m_LogBaseVersion; i < m_OccupancyLog.size(); ++i) {
+            func(m_OccupancyLog[i]);
+        }
+        return true;
     }
 
     bool IsTileOccupied(int x, int y) const {
         if (!IsValidTile(x, y)) {
             return true;
         }
-        return m_Grid[x][y] != ecs::MAX_ENTITIES;
+        return IsOccupiedIndex(TileIndex(x, y));
     }
 
     ecs::Entity GetEntityAt(int x, int y) const {
         if (!IsValidTile(x, y)) {
-            return ecs::MAX_ENTITIES;
+            return ecs::NULL_ENTITY;
         }
-        return m_Grid[x][y];
+        return m_Tiles[TileIndex(x, y)];
     }
 
     void SetEntityAt(int x, int y, ecs::Entity entity) {
         if (IsValidTile(x, y)) {
-            m_Grid[x][y] = entity;
+            int index = TileIndex(x, y);
+            bool occupied = entity != ecs::NULL_ENTITY;
+            bool occupancyChanged = IsOccupiedIndex(index) != occupied;
+            ecs::Entity previous = m_Tiles[index];
+            m_Tiles[index] = entity;
+            if (occupancyChanged) {
+                if (occupied) m_Occupied[index >> 6] |= uint64_t(1) << (index & 63);
+                else m_Occupied[index >> 6] &= ~(uint64_t(1) << (index & 63));
+                m_OccupancyLog.push_back({ { x, y }, occupied, occupied ? entity : previous });
+                ++m_OccupancyVersion;
+                if (m_OccupancyLog.size() >= 2 * OCCUPANCY_LOG_LIMIT) TrimOccupancyLog();
+            }
         }
     }
 
     bool IsWalkable(int x, int y) const {
-        return IsValidTile(x, y) && !IsTileOccupied(x, y);
+        return IsValidTile(x, y) && !IsOccupiedIndex(TileIndex(x, y));
     }
 
     bool IsValidTile(int x, int y) const {
-        return !(x < 0 || x >= GRID_WIDTH || y < 0 || y >= GRID_HEIGHT);
+        return !(x < 0 || x >= m_Width || y < 0 || y >= m_Height);
+    }
+
+    //bresenham walk between two tiles, true if no occupied tile is on it. the start tile itself is not checked
+    bool HasLineOfSight(glm::ivec2 from, glm::ivec2 to) const {
+        int x0 = from.x, y0 = from.y;
+        int dx = std::abs(to.x - x0), sx = x0 < to.x ? 1 : -1;
+        int dy = -std::abs(to.y - y0), sy = y0 < to.y ? 1 : -1;
+        int err = dx + dy;
+
+        while (true) {
+            if ((x0 != from.x || y0 != from.y) && IsTileOccupied(x0, y0)) return false;
+            if (x0 == to.x && y0 == to.y) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+        return true;
+    }
+
+    //calls func(x, y) for every tile the straight line between the two tile centers passes through, start to end.
+    //unlike bresenham it never slips diagonally past a corner: where the line runs exactly through a tile corner the
+    //two tiles beside it are visited too. func returns false to stop the walk, then this returns false as well
+    template<typename Func>
+    bool ForEachTileOnLine(glm::ivec2 from, glm::ivec2 to, Func func) const {
+        int nx = std::abs(to.x - from.x), sx = from.x < to.x ? 1 : -1;
+        int ny = std::abs(to.y - from.y), sy = from.y < to.y ? 1 : -1;
+        glm::ivec2 tile = from;
+        if (!func(tile.x, tile.y)) return false;
+        for (int ix = 0, iy = 0; ix < nx || iy < ny;) {
+            int decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+            if (decision == 0) {
+                if (!func(tile.x + sx, tile.y) || !func(tile.x, tile.y + sy)) return false;
+                tile.x += sx; tile.y += sy; ++ix; ++iy;
+            }
+            else if (decision < 0) { tile.x += sx; ++ix; }
+            else { tile.y += sy; ++iy; }
+            if (!func(tile.x, tile.y)) return false;
+        }
+        return true;
+    }
+
+    //can a unit walk the straight line between two tile centers. the start tile is not checked (units get pushed
+    //onto occupied tiles), the end tile only when endMayBeOccupied is false
+    bool IsLineWalkable(glm::ivec2 from, glm::ivec2 to, bool endMayBeOccupied = false) const {
+        return ForEachTileOnLine(from, to, [&](int x, int y) {
+            if (x == from.x && y == from.y) return true;
+            if (endMayBeOccupied && x == to.x && y == to.y) return true;
+            return IsWalkable(x, y);
+        });
     }
 
     glm::vec3 GridToWorld(int x, int y) const {
-        float posX = (float)x - (float)GRID_WIDTH / 2.0f + 0.5f;
-        float posZ = (float)y - (float)GRID_HEIGHT / 2.0f + 0.5f;
+        float posX = (float)x - (float)m_Width / 2.0f + 0.5f;
+        float posZ = (float)y - (float)m_Height / 2.0f + 0.5f;
         return { posX, 0.0f, posZ };
     }
 
     glm::ivec2 WorldToGrid(const glm::vec3& worldPos) const {
-        int x = static_cast<int>(std::floor(worldPos.x + (float)GRID_WIDTH / 2.0f));
-        int y = static_cast<int>(std::floor(worldPos.z + (float)GRID_HEIGHT / 2.0f));
+        int x = static_cast<int>(std::floor(worldPos.x + (float)m_Width / 2.0f));
+        int y = static_cast<int>(std::floor(worldPos.z + (float)m_Height / 2.0f));
         return { x, y };
     }
 
+    size_t GetMemoryUsage() const {
+        return m_Tiles.capacity() * sizeof(ecs::Entity) + m_Occupied.capacity() * sizeof(uint64_t) +
+            m_OccupancyLog.capacity() * sizeof(OccupancyChange);
+    }
+
 private:
-    std::vector<std::vector<ecs::Entity>> m_Grid;
-};
\ No newline at end of file
+    int m_Width = 0;
+    int m_Height = 0;
+    uint32_t m_OccupancyVersion = 0;
+    uint32_t m_LogBaseVersion = 0;
+    std::vector<OccupancyChange> m_OccupancyLog; //most recent flips; flip i moved the version to m_LogBaseVersion + i + 1
+    std::vector<ecs::Entity> m_Tiles;    //row-major, NULL_ENTITY when free
+    std::vector<uint64_t> m_Occupied;    //one bit per tile, same indexing as m_Tiles
+
+    int TileIndex(int x, int y) const { return y * m_Width + x; }
+
+    bool IsOccupiedIndex(int index) const {
+        return (m_Occupied[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void TrimOccupancyLog() {
+        size_t dropped = m_OccupancyLog.size() - OCCUPANCY_LOG_LIMIT;
+        m_OccupancyLog.erase(m_OccupancyLog.begin(), m_OccupancyLog.begin() + dropped);
+        m_LogBaseVersion += static_cast<uint32_t>(dropped);
+    }
+};
@@ -0,0 +1,435 @@
+#pragma once
+
+#include "GridSystem.h"
+#include "Pathfinder.h"
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <chrono>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+//HPA*: the map is cut into CLUSTER_SIZE square clusters. wherever two neighbouring clusters share open border
+//tiles there is an entrance, one abstract node on each side, and nodes in the same cluster are linked by their
+//BFS distance inside it. queries search that small graph and return entrance tiles; each leg is only expanded to
+//tiles (RefineSegment) once the unit gets there. a tile flip rebuilds its own cluster, plus the neighbour across
+//the border when the tile sits on one.
+//moves are 4-way with unit cost like Pathfinder, and the end tile may be occupied
+class HierarchicalPathfinder {
+public:
+    static constexpr int CLUSTER_SIZE = 16;
+    static constexpr int MAX_ENTRANCE_WIDTH = 6; //open runs this wide or wider get an entrance at each end instead of one in the middle
+
+    void Build(const GridSystem& grid) {
+        m_Width = grid.GetWidth();
+        m_Height = grid.GetHeight();
+        m_ClustersX = (m_Width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        m_ClustersY = (m_Height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        m_Clusters.assign(static_cast<size_t>(m_ClustersX) * m_ClustersY, Cluster{});
+        for (int c = 0; c < (int)m_Clusters.size(); ++c) {
+            RebuildCluster(grid, c);
+        }
+        RebuildNodeIndex();
+        m_LastUpdateClusters = m_Clusters.size();
+        m_Version = grid.GetOccupancyVersion();
+        m_Built = true;
+    }
+
+    //catches up with the grid: only clusters next to a flipped tile are rebuilt
+    void Update(const GridSystem& grid) {
+        if (m_Built && m_Version == grid.GetOccupancyVersion()) return;
+
+        std::vector<int> dirty;
+        bool incremental = m_Built && m_Width == grid.GetWidth() && m_Height == grid.GetHeight() &&
+            grid.ForEachOccupancyChangeSince(m_Version, [&](const OccupancyChange& change) {
+                int x = change.tile.x;
+                int y = change.tile.y;
+                int cx = x / CLUSTER_SIZE;
+                int cy = y / CLUSTER_SIZE;
+                dirty.push_back(ClusterIndex(cx, cy));
+                if (x % CLUSTER_SIZE == 0 && cx > 0) dirty.push_back(ClusterIndex(cx - 1, cy));
+                if (x % CLUSTER_SIZE == CLUSTER_SIZE - 1 && cx + 1 < m_ClustersX) dirty.push_back(ClusterIndex(cx + 1, cy));
+                if (y % CLUSTER_SIZE == 0 && cy > 0) dirty.push_back(ClusterIndex(cx, cy - 1));
+                if (y % CLUSTER_SIZE == CLUSTER_SIZE - 1 && cy + 1 < m_ClustersY) dirty.push_back(ClusterIndex(cx, cy + 1));
+            });
+        if (!incremental) {
+            Build(grid);
+            return;
+        }
+
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        for (int c : dirty) {
+            RebuildCluster(grid, c);
+        }
+        RebuildNodeIndex();
+        m_LastUpdateClusters = dirty.size();
+        m_Version = grid.GetOccupancyVersion();
+    }
+
+    bool IsCurrent(const GridSystem& grid) const { return m_Built && m_Version == grid.GetOccupancyVersion(); }
+
+    //start, the entrance tiles to pass through, end. empty if end can't be reached. Update first if the grid changed
+    std::vector<glm::ivec2> FindAbstractPath(const GridSystem& grid, glm::ivec2 start, glm::ivec2 end) {
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<glm::ivec2> path;
+        m_LastStats.nodesExpanded = 0;
+
+        if (m_Built && grid.IsValidTile(start.x, start.y) && grid.IsValidTile(end.x, end.y)) {
+            if (Search(grid, start, end)) {
+                for (int id = m_GoalId; id != NO_PARENT; id = m_Search[id].parent) {
+                    glm::ivec2 tile = NodeTile(id);
+                    if (path.empty() || path.back() != tile) path.push_back(tile);
+                }
+                std::reverse(path.begin(), path.end());
+            }
+        }
+
+        m_LastStats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        return path;
+    }
+
+    //tile centers from `from` to `to` for one leg of an abstract path. legs inside a cluster are a BFS over that
+    //cluster, a leg that steps over a border is just the two tiles. anything else (the unit got pushed off its
+    //route) falls back to flat A*. empty if the leg is blocked
+    std::vector<glm::vec3> RefineSegment(const GridSystem& grid, glm::ivec2 from, glm::ivec2 to) {
+        std::vector<glm::vec3> segment;
+        if (!grid.IsValidTile(from.x, from.y) || !grid.IsValidTile(to.x, to.y)) return segment;
+
+        if (std::abs(from.x - to.x) + std::abs(from.y - to.y) <= 1) {
+            segment.push_back(grid.GridToWorld(from.x, from.y));
+            if (from != to) segment.push_back(grid.GridToWorld(to.x, to.y));
+            return segment;
+        }
+
+        int cluster = ClusterOf(to);
+        if (!m_Built || cluster != ClusterOf(from)) {
+            return Pathfinder::FindPath(&grid, from, to);
+        }
+
+        const Cluster& cl = m_Clusters[cluster];
+        BfsInCluster(grid, cl, to, m_Scratch);
+        int dist = m_Scratch[LocalIndex(cl, from)];
+        if (dist < 0) {
+            return Pathfinder::FindPath(&grid, from, to); //from may be an occupied tile the unit was pushed into
+        }
+
+        //walk downhill from `from`, the BFS ran from `to`
+        glm::ivec2 tile = from;
+        segment.push_back(grid.GridToWorld(tile.x, tile.y));
+        while (dist > 0) {
+            for (int dir = 0; dir < 4; ++dir) {
+                glm::ivec2 next(tile.x + STEP_X[dir], tile.y + STEP_Y[dir]);
+                if (!Contains(cl, next)) continue;
+                int nextDist = m_Scratch[LocalIndex(cl, next)];
+                if (nextDist >= 0 && nextDist == dist - 1) {
+                    tile = next;
+                    dist = nextDist;
+                    break;
+                }
+            }
+            segment.push_back(grid.GridToWorld(tile.x, tile.y));
+        }
+        return segment;
+    }
+
+    const Pathfinder::QueryStats& GetLastStats() const { return m_LastStats; }
+    size_t GetClusterCount() const { return m_Clusters.size(); }
+    size_t GetNodeCount() const { return m_NodeCluster.size(); }
+    size_t GetLastUpdateClusters() const { return m_LastUpdateClusters; }
+
+    size_t GetMemoryUsage() const {
+        size_t bytes = m_Clusters.capacity() * sizeof(Cluster) + m_NodeOffset.capacity() * sizeof(int) +
+            m_NodeCluster.capacity() * sizeof(int) + m_Search.capacity() * sizeof(SearchRecord) +
+            m_Open.capacity() * sizeof(OpenEntry);
+        for (auto const& cluster : m_Clusters) {
+            bytes += cluster.nodes.capacity() * sizeof(Node) + cluster.distances.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr int NO_PARENT = -1;
+    static constexpr int STEP_X[4] = { 0, 0, 1, -1 };
+    static constexpr int STEP_Y[4] = { 1, -1, 0, 0 };
+
+    struct Node {
+        glm::ivec2 tile;
+        uint8_t exits = 0; //bit d set: the tile one STEP d away is an entrance node of the neighbouring cluster
+    };
+
+    struct Cluster {
+        glm::ivec2 min{ 0 }, max{ 0 };  //tile bounds, max exclusive
+        std::vector<Node> nodes;
+        std::vector<int> distances;     //nodes.size() squared, -1 when not connected inside the cluster
+    };
+
+    struct SearchRecord {
+        uint32_t generation = 0;
+        int gCost = 0;
+        int parent = NO_PARENT;
+        bool closed = false;
+    };
+
+    struct OpenEntry {
+        int fCost, gCost, id;
+        bool operator<(const OpenEntry& other) const { //max-heap on "worse", so the front is lowest f, then deepest
+            return fCost > other.fCost || (fCost == other.fCost && gCost < other.gCost);
+        }
+    };
+
+    int m_Width = 0, m_Height = 0;
+    int m_ClustersX = 0, m_ClustersY = 0;
+    std::vector<Cluster> m_Clusters;
+    std::vector<int> m_NodeOffset;  //first abstract id of each cluster, plus the total at the end
+    std::vector<int> m_NodeCluster; //cluster of each abstract id
+    uint32_t m_Version = 0;
+    bool m_Built = false;
+    size_t m_LastUpdateClusters = 0;
+
+    //per-query state; the query's start and end are two extra ids after the cluster nodes
+    std::vector<SearchRecord> m_Search;
+    std::vector<OpenEntry> m_Open;
+    uint32_t m_Generation = 0;
+    int m_StartId = 0, m_GoalId = 0;
+    glm::ivec2 m_Start{ 0 }, m_Goal{ 0 };
+    std::vector<int> m_StartDistances, m_GoalDistances, m_Scratch; //BFS results over one cluster's tiles
+    std::vector<int> m_Queue;
+    Pathfinder::QueryStats m_LastStats;
+
+    int ClusterIndex(int cx, int cy) const { return cy * m_ClustersX + cx; }
+    int ClusterOf(glm::ivec2 tile) const { return ClusterIndex(tile.x / CLUSTER_SIZE, tile.y / CLUSTER_SIZE); }
+    static bool Contains(const Cluster& cl, glm::ivec2 tile) {
+        return tile.x >= cl.min.x && tile.x < cl.max.x && tile.y >= cl.min.y && tile.y < cl.max.y;
+    }
+    static int LocalIndex(const Cluster& cl, glm::ivec2 tile) { return (tile.y - cl.min.y) * CLUSTER_SIZE + (tile.x - cl.min.x); }
+    static int Heuristic(glm::ivec2 a, glm::ivec2 b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
+
+    glm::ivec2 NodeTile(int id) const {
+        if (id == m_StartId) return m_Start;
+        if (id == m_GoalId) return m_Goal;
+        int cluster = m_NodeCluster[id];
+        return m_Clusters[cluster].nodes[id - m_NodeOffset[cluster]].tile;
+    }
+
+    void AddNode(Cluster& cl, glm::ivec2 tile, int dir) {
+        for (auto& node : cl.nodes) {
+            if (node.tile == tile) { //corner tiles can be an entrance on two borders
+                node.exits |= uint8_t(1 << dir);
+                return;
+            }
+        }
+        cl.nodes.push_back({ tile, uint8_t(1 << dir) });
+    }
+
+    //walks one border tile by tile, `inside(k)` is the k-th tile of this cluster along it. both clusters run the
+    //same scan over the same tile pairs, so they always agree on where the entrances are
+    template<typename Inside>
+    void AddEntrances(const GridSystem& grid, Cluster& cl, int length, int dir, Inside inside) {
+        int runStart = -1;
+        for (int k = 0; k <= length; ++k) {
+            bool open = false;
+            if (k < length) {
+                glm::ivec2 a = inside(k);
+                open = grid.IsWalkable(a.x, a.y) && grid.IsWalkable(a.x + STEP_X[dir], a.y + STEP_Y[dir]);
+            }
+            if (open && runStart < 0) runStart = k;
+            if (!open && runStart >= 0) {
+                int runLength = k - runStart;
+                if (runLength >= MAX_ENTRANCE_WIDTH) {
+                    AddNode(cl, inside(runStart), dir);
+                    AddNode(cl, inside(k - 1), dir);
+                }
+                else {
+                    AddNode(cl, inside(runStart + (runLength - 1) / 2), dir);
+                }
+                runStart = -1;
+            }
+        }
+    }
+
+    void RebuildCluster(const GridSystem& grid, int index) {
+        Cluster& cl = m_Clusters[index];
+        int cx = index % m_ClustersX;
+        int cy = index / m_ClustersX;
+        cl.min = { cx * CLUSTER_SIZE, cy * CLUSTER_SIZE };
+        cl.max = { std::min(cl.min.x + CLUSTER_SIZE, m_Width), std::min(cl.min.y + CLUSTER_SIZE, m_Height) };
+        cl.nodes.clear();
+
+        int width = cl.max.x - cl.min.x;
+        int height = cl.max.y - cl.min.y;
+        if (cl.max.y < m_Height) AddEntrances(grid, cl, width, 0, [&](int k) { return glm::ivec2(cl.min.x + k, cl.max.y - 1); });
+        if (cl.min.y > 0) AddEntrances(grid, cl, width, 1, [&](int k) { return glm::ivec2(cl.min.x + k, cl.min.y); });
+        if (cl.max.x < m_Width) AddEntrances(grid, cl, height, 2, [&](int k) { return glm::ivec2(cl.max.x - 1, cl.min.y + k); });
+        if (cl.min.x > 0) AddEntrances(grid, cl, height, 3, [&](int k) { return glm::ivec2(cl.min.x, cl.min.y + k); });
+
+        ComputeNodeDistances(grid, cl);
+    }
+
+    //one BFS per node, run as a bitmask wavefront: each row of the cluster is one word, so a whole BFS layer
+    //advances with a few shifts and ands per row instead of a branch per tile
+    void ComputeNodeDistances(const GridSystem& grid, Cluster& cl) {
+        using Row = uint32_t;
+        static_assert(CLUSTER_SIZE <= 32, "a cluster row has to fit in one Row");
+        int width = cl.max.x - cl.min.x;
+        int height = cl.max.y - cl.min.y;
+        Row walkable[CLUSTER_SIZE] = {};
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (grid.IsWalkable(cl.min.x + x, cl.min.y + y)) walkable[y] |= Row(1) << x;
+            }
+        }
+
+        size_t count = cl.nodes.size();
+        Row nodeRows[CLUSTER_SIZE] = {};
+        for (auto const& node : cl.nodes) {
+            nodeRows[node.tile.y - cl.min.y] |= Row(1) << (node.tile.x - cl.min.x);
+        }
+        cl.distances.assign(count * count, -1);
+        for (size_t i = 0; i < count; ++i) {
+            Row frontier[CLUSTER_SIZE] = {};
+            Row visited[CLUSTER_SIZE] = {};
+            glm::ivec2 origin = cl.nodes[i].tile - cl.min;
+            frontier[origin.y] = visited[origin.y] = Row(1) << origin.x;
+            cl.distances[i * count + i] = 0;
+            size_t found = 1;
+
+            for (int dist = 1; found < count; ++dist) {
+                Row next[CLUSTER_SIZE];
+                Row any = 0, reachedNode = 0;
+                for (int y = 0; y < height; ++y) {
+                    Row grow = frontier[y] | (frontier[y] << 1) | (frontier[y] >> 1);
+                    if (y > 0) grow |= frontier[y - 1];
+                    if (y + 1 < height) grow |= frontier[y + 1];
+                    next[y] = grow & walkable[y] & ~visited[y];
+                    any |= next[y];
+                    reachedNode |= next[y] & nodeRows[y];
+                }
+                if (!any) break;
+                for (int y = 0; y < height; ++y) {
+                    frontier[y] = next[y];
+                    visited[y] |= next[y];
+                }
+                if (!reachedNode) continue;
+                for (size_t j = 0; j < count; ++j) {
+                    glm::ivec2 tile = cl.nodes[j].tile - cl.min;
+                    if (cl.distances[i * count + j] < 0 && ((frontier[tile.y] >> tile.x) & 1)) {
+                        cl.distances[i * count + j] = dist;
+                        ++found;
+                    }
+                }
+            }
+        }
+    }
+
+    void RebuildNodeIndex() {
+        m_NodeOffset.assign(m_Clusters.size() + 1, 0);
+        for (size_t c = 0; c < m_Clusters.size(); ++c) {
+            m_NodeOffset[c + 1] = m_NodeOffset[c] + (int)m_Clusters[c].nodes.size();
+        }
+        m_NodeCluster.resize(m_NodeOffset.back());
+        for (size_t c = 0; c < m_Clusters.size(); ++c) {
+            std::fill(m_NodeCluster.begin() + m_NodeOffset[c], m_NodeCluster.begin() + m_NodeOffset[c + 1], (int)c);
+        }
+    }
+
+    //steps from origin to every tile of the cluster without leaving it, -1 if unreachable. origin itself may be
+    //occupied (a building being targeted)
+    void BfsInCluster(const GridSystem& grid, const Cluster& cl, glm::ivec2 origin, std::vector<int>& distances) {
+        distances.assign(CLUSTER_SIZE * CLUSTER_SIZE, -1);
+        m_Queue.clear();
+        distances[LocalIndex(cl, origin)] = 0;
+        m_Queue.push_back(LocalIndex(cl, origin));
+        for (size_t head = 0; head < m_Queue.size(); ++head) {
+            int local = m_Queue[head];
+            glm::ivec2 tile(cl.min.x + local % CLUSTER_SIZE, cl.min.y + local / CLUSTER_SIZE);
+            for (int dir = 0; dir < 4; ++dir) {
+                glm::ivec2 next(tile.x + STEP_X[dir], tile.y + STEP_Y[dir]);
+                if (!Contains(cl, next) || !grid.IsWalkable(next.x, next.y)) continue;
+                int nextLocal = LocalIndex(cl, next);
+                if (distances[nextLocal] >= 0) continue;
+                distances[nextLocal] = distances[local] + 1;
+                m_Queue.push_back(nextLocal);
+            }
+        }
+    }
+
+    void Relax(int id, int parent, int gCost) {
+        SearchRecord& record = m_Search[id];
+        if (record.generation == m_Generation && (record.closed || record.gCost <= gCost)) return;
+        record = { m_Generation, gCost, parent, false };
+        m_Open.push_back({ gCost + Heuristic(NodeTile(id), m_Goal), gCost, id });
+        std::push_heap(m_Open.begin(), m_Open.end());
+    }
+
+    //A* over the cluster nodes plus the query's start and goal, which are linked into their clusters by BFS
+    bool Search(const GridSystem& grid, glm::ivec2 start, glm::ivec2 goal) {
+        int nodeCount = m_NodeOffset.back();
+        m_StartId = nodeCount;
+        m_GoalId = nodeCount + 1;
+        m_Start = start;
+        m_Goal = goal;
+        if (m_Search.size() != (size_t)nodeCount + 2 || ++m_Generation == 0) {
+            m_Search.assign(nodeCount + 2, SearchRecord{});
+            m_Generation = 1;
+        }
+        m_Open.clear();
+
+        int startCluster = ClusterOf(start);
+        int goalCluster = ClusterOf(goal);
+        BfsInCluster(grid, m_Clusters[startCluster], start, m_StartDistances);
+        BfsInCluster(grid, m_Clusters[goalCluster], goal, m_GoalDistances);
+
+        Relax(m_StartId, NO_PARENT, 0);
+        while (!m_Open.empty()) {
+            std::pop_heap(m_Open.begin(), m_Open.end());
+            OpenEntry entry = m_Open.back();
+            m_Open.pop_back();
+            SearchRecord& record = m_Search[entry.id];
+            if (record.closed || entry.gCost != record.gCost) continue; //stale duplicate
+            record.closed = true;
+            ++m_LastStats.nodesExpanded;
+            if (entry.id == m_GoalId) return true;
+
+            if (entry.id == m_StartId) {
+                const Cluster& cl = m_Clusters[startCluster];
+                for (size_t j = 0; j < cl.nodes.size(); ++j) {
+                    int dist = m_StartDistances[LocalIndex(cl, cl.nodes[j].tile)];
+                    if (dist >= 0) Relax(m_NodeOffset[startCluster] + (int)j, m_StartId, dist);
+                }
+                if (startCluster == goalCluster) {
+                    int dist = m_StartDistances[LocalIndex(cl, goal)];
+                    if (dist >= 0) Relax(m_GoalId, m_StartId, dist);
+                }
+                continue;
+            }
+
+            int cluster = m_NodeCluster[entry.id];
+            const Cluster& cl = m_Clusters[cluster];
+            size_t local = entry.id - m_NodeOffset[cluster];
+            const Node& node = cl.nodes[local];
+
+            for (size_t j = 0; j < cl.nodes.size(); ++j) {
+                int dist = cl.distances[local * cl.nodes.size() + j];
+                if (j != local && dist >= 0) Relax(m_NodeOffset[cluster] + (int)j, entry.id, entry.gCost + dist);
+            }
+            for (int dir = 0; dir < 4; ++dir) {
+                if (!(node.exits & (1 << dir))) continue;
+                glm::ivec2 across(node.tile.x + STEP_X[dir], node.tile.y + STEP_Y[dir]);
+                int other = ClusterOf(across);
+                const Cluster& otherCluster = m_Clusters[other];
+                for (size_t j = 0; j < otherCluster.nodes.size(); ++j) {
+                    if (otherCluster.nodes[j].tile == across) {
+                        Relax(m_NodeOffset[other] + (int)j, entry.id, entry.gCost + 1);
+                        break;
+                    }
+                }
+            }
+            if (cluster == goalCluster) {
+                int dist = m_GoalDistances[LocalIndex(cl, node.tile)];
+                if (dist >= 0) Relax(m_GoalId, entry.id, entry.gCost + dist);
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+//work-stealing job system. every worker owns a deque: it pushes and pops its own jobs at the back (newest first,
+//still warm in cache) and steals from the front of the other deques when it runs dry. threads outside the pool
+//push to a shared injection deque. a thread waiting on a job keeps running other jobs meanwhile, so jobs can
+//schedule and wait on child jobs (a ParallelFor inside a scheduled system) without deadlocking
+class JobSystem {
+public:
+    class Job {
+    public:
+        bool IsFinished() const { return m_Finished.load(std::memory_order_acquire); }
+
+    private:
+        friend class JobSystem;
+        std::function<void()> m_Work;
+        std::atomic<size_t> m_PendingDependencies{ 1 }; //the extra 1 is released once Schedule has wired every dependency
+        std::atomic<bool> m_Finished{ false };
+        std::mutex m_Mutex;
+        std::vector<std::shared_ptr<Job>> m_Continuations;
+    };
+    using JobHandle = std::shared_ptr<Job>;
+
+    explicit JobSystem(size_t workerCount = DefaultWorkerCount()) : m_ActiveWorkers(workerCount) {
+        for (size_t i = 0; i <= workerCount; ++i) {
+            m_Queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            m_Workers.emplace_back([this, i]() { WorkerLoop(i + 1); });
+        }
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stopping = true;
+        }
+        m_WakeUp.notify_all();
+        for (auto& worker : m_Workers) {
+            worker.join();
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    //work starts once every dependency has finished
+    JobHandle Schedule(std::function<void()> work, const std::vector<JobHandle>& dependencies = {}) {
+        auto job = std::make_shared<Job>();
+        job->m_Work = std::move(work);
+        for (auto const& dependency : dependencies) {
+            if (!dependency) continue;
+            std::lock_guard<std::mutex> lock(dependency->m_Mutex);
+            if (!dependency->m_Finished.load(std::memory_order_relaxed)) {
+                job->m_PendingDependencies.fetch_add(1, std::memory_order_relaxed);
+                dependency->m_Continuations.push_back(job);
+            }
+        }
+        if (job->m_PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Push(job);
+        }
+        return job;
+    }
+
+    void Wait(const JobHandle& job) {
+        while (!job->IsFinished()) {
+            JobHandle next = TryGetJob(QueueIndex());
+            if (next) Execute(next);
+            else std::this_thread::yield();
+        }
+    }
+
+    void WaitAll(const std::vector<JobHandle>& jobs) {
+        for (auto const& job : jobs) Wait(job);
+    }
+
+    //calls body(begin, end) over chunks of [0, count) and returns once all of them are done. the calling thread
+    //runs the first chunk itself; ranges no bigger than minChunk never leave it
+    template<typename Func>
+    void ParallelFor(size_t count, Func&& body, size_t minChunk = 256) {
+        size_t threads = m_ActiveWorkers.load(std::memory_order_relaxed) + 1;
+        if (count == 0) return;
+        if (threads == 1 || count <= minChunk) {
+            body(size_t(0), count);
+            return;
+        }
+
+        size_t chunkCount = std::min((count + minChunk - 1) / minChunk, threads * 4);
+        size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+        std::vector<JobHandle> chunks;
+        chunks.reserve(chunkCount);
+        for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+            size_t end = std::min(begin + chunkSize, count);
+            chunks.push_back(Schedule([&body, begin, end]() { body(begin, end); }));
+        }
+        body(size_t(0), std::min(chunkSize, count));
+        WaitAll(chunks);
+    }
+
+    size_t GetWorkerCount() const { return m_Workers.size(); }
+
+    //caps how many workers pick up jobs, used to measure scaling. 0 runs everything on the calling thread
+    void SetActiveWorkers(size_t count) {
+        m_ActiveWorkers = std::min(count, m_Workers.size());
+        Notify(true);
+    }
+    size_t GetActiveWorkers() const { return m_ActiveWorkers; }
+
+    //leaves one core for the main thread, which also runs jobs while it waits
+    static size_t DefaultWorkerCount() {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 1;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_Queues; //[0] is the injection queue, [i] belongs to worker i
+    std::vector<std::thread> m_Workers;
+    std::atomic<size_t> m_ActiveWorkers;
+    std::atomic<size_t> m_QueuedJobs{ 0 };
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeUp;
+    bool m_Stopping = false;
+
+    static inline thread_local const JobSystem* s_Owner = nullptr;
+    static inline thread_local size_t s_QueueIndex = 0;
+
+    size_t QueueIndex() const { return s_Owner == this ? s_QueueIndex : 0; }
+
+    void Push(JobHandle job) {
+        Queue& queue = *m_Queues[QueueIndex()];
+        m_QueuedJobs.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+        Notify(false);
+    }
+
+    void Notify(bool all) {
+        { std::lock_guard<std::mutex> lock(m_SleepMutex); } //a worker between its check and its wait would miss the notify
+        if (all) m_WakeUp.notify_all();
+        else m_WakeUp.notify_one();
+    }
+
+    JobHandle TryGetJob(size_t self) {
+        if (m_QueuedJobs.load(std::memory_order_acquire) == 0) return nullptr;
+        {
+            Queue& own = *m_Queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                JobHandle job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        for (size_t offset = 1; offset < m_Queues.size(); ++offset) {
+            Queue& victim = *m_Queues[(self + offset) % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                JobHandle job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void Execute(const JobHandle& job) {
+        job->m_Work();
+        job->m_Work = nullptr;
+
+        std::vector<JobHandle> continuations;
+        {
+            std::lock_guard<std::mutex> lock(job->m_Mutex);
+            job->m_Finished.store(true, std::memory_order_release);
+            continuations.swap(job->m_Continuations);
+        }
+        for (auto const& continuation : continuations) {
+            if (continuation->m_PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                Push(continuation);
+            }
+        }
+    }
+
+    void WorkerLoop(size_t index) {
+        s_Owner = this;
+        s_QueueIndex = index;
+        while (true) {
+            if (index <= m_ActiveWorkers.load(std::memory_order_relaxed)) {
+                JobHandle job = TryGetJob(index);
+                if (job) {
+                    Execute(job);
+                    continue;
+                }
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_WakeUp.wait(lock, [this, index]() {
+                return m_Stopping ||
+                    (index <= m_ActiveWorkers.load(std::memory_order_relaxed) && m_QueuedJobs.load(std::memory_order_acquire) > 0);
+            });
+            if (m_Stopping) return;
+        }
+    }
+};
@@ -2,57 +2,98 @@
 
 #include "ECS.h"
 #include "Components.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "PathPool.h"
 #include <glm/glm.hpp>
 #include <iostream>
+#include <vector>
+#include <mutex>
+#include <algorithm>
 
 class MovementSystem : public ecs::System {
 public:
+    void Init(JobSystem* jobs, const PathPool* paths) {
+        m_Jobs = jobs;
+        m_Paths = paths;
+    }
+
+    //every enemy only writes its own transform/movement, so the pool is split across workers. arrivals are gathered
+    //per chunk and logged afterwards in entity order, so workers don't fight over cout
     void Update(float dt) {
-        for (auto const& entity : m_Entities) {
-            auto& transform = m_Registry->GetComponent<TransformComponent>(entity);
-            auto& movement = m_Registry->GetComponent<MovementComponent>(entity);
+        auto movers = m_Registry->View<TransformComponent, MovementComponent>();
+        std::vector<Arrival> arrivals;
+        std::mutex arrivalsMutex;
 
-            if (movement.isAttacking) {
-                continue; //if attacking->stop moving
-            }
+        m_Jobs->ParallelFor(movers.SizeHint(), [&](size_t begin, size_t end) {
+            std::vector<Arrival> chunkArrivals;
+            movers.EachInRange(begin, end, [&](ecs::Entity entity, TransformComponent& transform, MovementComponent& movement) {
+                if (Move(dt, transform, movement)) chunkArrivals.push_back({ entity, movement.targetEntity });
+            });
+            if (chunkArrivals.empty()) return;
+            std::lock_guard<std::mutex> lock(arrivalsMutex);
+            arrivals.insert(arrivals.end(), chunkArrivals.begin(), chunkArrivals.end());
+        });
 
-            if (movement.path.empty() || movement.currentPathIndex >= movement.path.size()) {
-                continue; //no path
-            }
+        std::sort(arrivals.begin(), arrivals.end(), [](const Arrival& a, const Arrival& b) { return a.enemy < b.enemy; });
+        for (auto const& arrival : arrivals) {
+            std::cout << "Enemy " << arrival.enemy << " reached target " << arrival.target << " and is attacking!" << std::endl;
+        }
+    }
 
-            if (movement.targetEntity != ecs::MAX_ENTITIES &&
-                m_Registry->HasComponent<TransformComponent>(movement.targetEntity) &&
-                movement.currentPathIndex == movement.path.size() - 1) 
-            {
-                auto& targetTransform = m_Registry->GetComponent<TransformComponent>(movement.targetEntity);
-                
-                
-                glm::vec2 pos2D = {transform.position.x, transform.position.z};
-                glm::vec2 target2D = {targetTransform.position.x, targetTransform.position.z};
-                float stopDistance = 1.5f; 
-                
-                if (glm::distance(pos2D, target2D) <= stopDistance) {
-                    movement.isAttacking = true;
-                    movement.path.clear();
-                    std::cout << "Enemy " << entity << " reached target " << movement.targetEntity << " and is attacking!" << std::endl;
-                    continue;
-                }
-            }
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess().Write<TransformComponent, MovementComponent>().ReadResource<PathPool>();
+    }
+
+private:
+    struct Arrival {
+        ecs::Entity enemy, target;
+    };
+
+    JobSystem* m_Jobs = nullptr;
+    const PathPool* m_Paths = nullptr;
 
+    //true when the enemy got into attack range of its target this tick
+    bool Move(float dt, TransformComponent& transform, MovementComponent& movement) {
+        if (movement.isAttacking) {
+            return false; //if attacking->stop moving
+        }
+
+        if (movement.path.Empty() || movement.currentPathIndex >= movement.path.Size()) {
+            return false; //no path
+        }
 
-            glm::vec3 targetWaypoint = movement.path[movement.currentPathIndex];
+        if (m_Registry->IsAlive(movement.targetEntity) &&
+            movement.currentPathIndex == movement.path.Size() - 1) 
+        {
+            auto& targetTransform = m_Registry->GetComponent<TransformComponent>(movement.targetEntity);
+            
+            
             glm::vec2 pos2D = {transform.position.x, transform.position.z};
-            glm::vec2 target2D = {targetWaypoint.x, targetWaypoint.z};
-            float distance = glm::distance(pos2D, target2D);
+            glm::vec2 target2D = {targetTransform.position.x, targetTransform.position.z};
+            float stopDistance = 1.5f; 
             
-            targetWaypoint.y = transform.position.y;
-            glm::vec3 direction = glm::normalize(targetWaypoint - transform.position);
-
-            if (distance < 0.1f) {
-                movement.currentPathIndex++; 
-            } else {
-                transform.position += direction * movement.speed * dt;
+            if (glm::distance(pos2D, target2D) <= stopDistance) {
+                movement.isAttacking = true;
+                movement.path.Clear();
+                return true;
             }
         }
+
+
+        glm::vec3 targetWaypoint = m_Paths->GetWaypoint(movement.path, movement.currentPathIndex);
+        glm::vec2 pos2D = {transform.position.x, transform.position.z};
+        glm::vec2 target2D = {targetWaypoint.x, targetWaypoint.z};
+        float distance = glm::distance(pos2D, target2D);
+        
+        targetWaypoint.y = transform.position.y;
+        glm::vec3 direction = glm::normalize(targetWaypoint - transform.position);
+
+        if (distance < 0.1f) {
+            movement.currentPathIndex++; 
+        } else {
+            transform.position += direction * movement.speed * dt;
+        }
+        return false;
     }
 };
\ No newline at end of file
@@ -36,7 +36,7 @@ public:
 
     glm::mat4 GetProjectionMatrix(float aspectRatio) const
     {
-        return glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
+        return glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, m_FarPlane);
     }
 
     glm::vec3 GetPosition() const { return m_Position; }
@@ -47,6 +47,7 @@ public:
 
     void SetTarget(const glm::vec3& target) {
         m_Target = target;
+        clampTarget();
         updateCameraPosition();
     }
     void SetDistance(float distance) {
@@ -54,6 +55,17 @@ public:
         updateCameraPosition();
     }
 
+    //keeps the target over a map of the given half size and lets the camera zoom out far enough to see all of it
+    void SetBounds(const glm::vec2& halfExtent)
+    {
+        m_HalfExtent = halfExtent;
+        m_MaxDistance = std::max(MAX_DISTANCE, 2.0f * std::max(halfExtent.x, halfExtent.y));
+        m_FarPlane = std::max(100.0f, 2.5f * m_MaxDistance);
+        m_Distance = std::min(m_Distance, m_MaxDistance);
+        clampTarget();
+        updateCameraPosition();
+    }
+
     void ProcessMousePan(float xoffset, float yoffset)
     {
         glm::vec3 panRight = glm::normalize(glm::vec3(cos(m_Yaw), 0.0f, -sin(m_Yaw)));
@@ -61,6 +73,7 @@ public:
         float distanceFactor = m_Distance / MAX_DISTANCE;
         m_Target -= panRight * xoffset * m_PanSpeed * distanceFactor;
         m_Target -= panForward * yoffset * m_PanSpeed * distanceFactor;
+        clampTarget();
         updateCameraPosition();
     }
 
@@ -72,12 +85,19 @@ public:
 
     void ProcessMouseScroll(float yoffset)
     {
-        m_Distance -= yoffset;
-        m_Distance = std::max(MIN_DISTANCE, std::min(m_Distance, MAX_DISTANCE));
+        //same step as before up to MAX_DISTANCE, proportional beyond it so big maps don't take hundreds of notches
+        m_Distance -= yoffset * std::max(1.0f, m_Distance / MAX_DISTANCE);
+        m_Distance = std::max(MIN_DISTANCE, std::min(m_Distance, m_MaxDistance));
         updateCameraPosition();
     }
 
 private:
+    void clampTarget()
+    {
+        m_Target.x = std::max(-m_HalfExtent.x, std::min(m_Target.x, m_HalfExtent.x));
+        m_Target.z = std::max(-m_HalfExtent.y, std::min(m_Target.z, m_HalfExtent.y));
+    }
+
     void updateCameraPosition()
     {
         m_Position.x = m_Target.x + (m_Distance * cos(m_Pitch)) * sin(m_Yaw);
@@ -90,4 +110,7 @@ private:
     glm::vec3 m_WorldUp;
     float m_Distance, m_Yaw, m_Pitch;
     float m_PanSpeed, m_OrbitSensitivity;
+    glm::vec2 m_HalfExtent{ 1e6f, 1e6f };
+    float m_MaxDistance = MAX_DISTANCE;
+    float m_FarPlane = 100.0f;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "PathRequestService.h"
+#include "Pathfinder.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+//answers from earlier path searches, keyed by (start tile, goal tile), so a wave walking out of one spawn point
+//towards the same building only pays for the first search. every answer belongs to the grid occupancy version it
+//was solved at; the first lookup or store after the version moves on drops the lot. least recently used entries
+//are evicted once the cache is full. results are shared and never modified after they are stored.
+//entries sit in one flat array that lookups scan: a few hundred keys are a handful of cache lines, and unlike a
+//list plus hash map it doesn't allocate a node per stored answer
+class PathCache {
+public:
+    void Clear() {
+        m_Entries.clear();
+    }
+
+    //nullptr on a miss
+    std::shared_ptr<const PathResult> Find(glm::ivec2 start, glm::ivec2 goal, uint32_t version) {
+        SyncVersion(version);
+        Entry* entry = Lookup(Pathfinder::QueryKey(start, goal));
+        if (!entry) {
+            ++m_Misses;
+            return nullptr;
+        }
+        entry->lastUsed = ++m_UseClock;
+        ++m_Hits;
+        return entry->result;
+    }
+
+    void Store(glm::ivec2 start, glm::ivec2 goal, uint32_t version, std::shared_ptr<const PathResult> result) {
+        if (m_Capacity == 0) return;
+        SyncVersion(version);
+        uint64_t key = Pathfinder::QueryKey(start, goal);
+        Entry* entry = Lookup(key);
+        if (!entry) {
+            if (m_Entries.size() < m_Capacity) {
+                m_Entries.push_back({});
+                entry = &m_Entries.back();
+            }
+            else {
+                entry = &*LeastRecentlyUsed();
+            }
+            entry->key = key;
+        }
+        entry->lastUsed = ++m_UseClock;
+        entry->result = std::move(result);
+    }
+
+    void SetCapacity(size_t capacity) {
+        m_Capacity = capacity;
+        while (m_Entries.size() > m_Capacity) EvictLeastRecentlyUsed();
+    }
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetSize() const { return m_Entries.size(); }
+    size_t GetHits() const { return m_Hits; }
+    size_t GetMisses() const { return m_Misses; }
+    size_t GetInvalidations() const { return m_Invalidations; }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        uint64_t lastUsed = 0; //m_UseClock at the last find or store
+        std::shared_ptr<const PathResult> result;
+    };
+
+    std::vector<Entry> m_Entries; //unordered, never more than m_Capacity
+    size_t m_Capacity = 256;
+    uint64_t m_UseClock = 0;
+    uint32_t m_Version = 0;
+
+    size_t m_Hits = 0;
+    size_t m_Misses = 0;
+    size_t m_Invalidations = 0; //times the grid changed under a non-empty cache
+
+    Entry* Lookup(uint64_t key) {
+        for (auto& entry : m_Entries) {
+            if (entry.key == key) return &entry;
+        }
+        return nullptr;
+    }
+
+    std::vector<Entry>::iterator LeastRecentlyUsed() {
+        return std::min_element(m_Entries.begin(), m_Entries.end(), [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+    }
+
+    void EvictLeastRecentlyUsed() {
+        auto oldest = LeastRecentlyUsed();
+        *oldest = std::move(m_Entries.back());
+        m_Entries.pop_back();
+    }
+
+    void SyncVersion(uint32_t version) {
+        if (version == m_Version) return;
+        if (!m_Entries.empty()) ++m_Invalidations;
+        Clear();
+        m_Version = version;
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ECS.h"
+#include "GridSystem.h"
+#include "PathPool.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+//which enemy paths run over which tile, so an occupancy change only ever touches the paths that cross it.
+//entries are tagged with the stamp of the path they came from; once the entity gets a new path the old entries go
+//stale. stale entries are dropped when a lookup runs into them and swept out once they outnumber the live ones.
+//every tile maps to a slot holding its entries; a tile that empties hands its slot back with the capacity intact,
+//so once the index has warmed up registering a path doesn't allocate
+class PathIndex {
+public:
+    struct Entry {
+        ecs::Entity entity;
+        uint32_t stamp;
+    };
+
+    void Clear() {
+        m_TileSlots.clear();
+        m_FreeSlots.clear();
+        for (size_t slot = 0; slot < m_Slots.size(); ++slot) {
+            m_Slots[slot].tile = NO_SLOT;
+            m_Slots[slot].entries.clear();
+            m_FreeSlots.push_back(static_cast<int>(slot));
+        }
+        m_EntryCount = 0;
+        m_LiveAfterSweep = 0;
+    }
+
+    //indexes the pooled path under the given stamp. waypoints can be several tiles apart after smoothing, so every
+    //tile the straight lines between them touch is indexed
+    template<typename IsCurrent>
+    void Register(ecs::Entity entity, uint32_t stamp, const GridSystem& grid, const PathPool& pool, const PathHandle& path, IsCurrent isCurrent) {
+        size_t tileCount = static_cast<size_t>(grid.GetWidth()) * static_cast<size_t>(grid.GetHeight());
+        if (m_TileSlots.size() != tileCount) {
+            Clear();
+            m_TileSlots.assign(tileCount, NO_SLOT);
+        }
+        for (size_t i = 0; i < path.Size(); ++i) {
+            glm::ivec2 to = pool.GetTile(path, i);
+            glm::ivec2 from = i > 0 ? pool.GetTile(path, i - 1) : to;
+            grid.ForEachTileOnLine(from, to, [&](int x, int y) {
+                if ((i > 0 && x == from.x && y == from.y) || !grid.IsValidTile(x, y)) return true; //already indexed
+                SlotFor(y * grid.GetWidth() + x).entries.push_back({ entity, stamp });
+                ++m_EntryCount;
+                return true;
+            });
+        }
+        if (m_EntryCount > 2 * m_LiveAfterSweep + SWEEP_SLACK) {
+            Sweep(isCurrent);
+        }
+    }
+
+    //func(entity) for every current path crossing the tile. isCurrent(entity, stamp) tells live entries from stale
+    template<typename IsCurrent, typename Func>
+    void ForEachOnTile(const GridSystem& grid, glm::ivec2 tile, IsCurrent isCurrent, Func func) {
+        if (!grid.IsValidTile(tile.x, tile.y)) return;
+        size_t index = static_cast<size_t>(tile.y) * grid.GetWidth() + tile.x;
+        if (index >= m_TileSlots.size() || m_TileSlots[index] == NO_SLOT) return;
+        int slot = m_TileSlots[index];
+        auto& entries = m_Slots[slot].entries;
+        size_t kept = 0;
+        for (auto const& entry : entries) {
+            if (!isCurrent(entry.entity, entry.stamp)) continue;
+            entries[kept++] = entry;
+            func(entry.entity);
+        }
+        m_EntryCount -= entries.size() - kept;
+        entries.resize(kept);
+        if (entries.empty()) ReleaseSlot(slot);
+    }
+
+    template<typename IsCurrent>
+    void Sweep(IsCurrent isCurrent) {
+        m_EntryCount = 0;
+        for (size_t slot = 0; slot < m_Slots.size(); ++slot) {
+            if (m_Slots[slot].tile == NO_SLOT) continue;
+            auto& entries = m_Slots[slot].entries;
+            size_t kept = 0;
+            for (auto const& entry : entries) {
+                if (isCurrent(entry.entity, entry.stamp)) entries[kept++] = entry;
+            }
+            entries.resize(kept);
+            m_EntryCount += kept;
+            if (entries.empty()) ReleaseSlot(static_cast<int>(slot));
+        }
+        m_LiveAfterSweep = m_EntryCount;
+    }
+
+    size_t GetEntryCount() const { return m_EntryCount; }
+
+private:
+    static constexpr size_t SWEEP_SLACK = 4096;
+    static constexpr int NO_SLOT = -1;
+
+    struct Slot {
+        int tile = NO_SLOT; //tile index (y * width + x) the slot belongs to, NO_SLOT while free
+        std::vector<Entry> entries;
+    };
+
+    std::vector<int> m_TileSlots; //tile index -> slot in m_Slots, NO_SLOT when no path crosses it
+    std::vector<Slot> m_Slots;
+    std::vector<int> m_FreeSlots;
+    size_t m_EntryCount = 0;
+    size_t m_LiveAfterSweep = 0;
+
+    Slot& SlotFor(int tile) {
+        int& slot = m_TileSlots[tile];
+        if (slot == NO_SLOT) {
+            if (m_FreeSlots.empty()) {
+                m_FreeSlots.push_back(static_cast<int>(m_Slots.size()));
+                m_Slots.emplace_back();
+            }
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+            m_Slots[slot].tile = tile;
+        }
+        return m_Slots[slot];
+    }
+
+    void ReleaseSlot(int slot) {
+        m_TileSlots[m_Slots[slot].tile] = NO_SLOT;
+        m_Slots[slot].tile = NO_SLOT;
+        m_FreeSlots.push_back(slot);
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Components.h"
+#include "GridSystem.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+//every unit path in one arena of packed tile indices (y * width + x) instead of a vector per MovementComponent.
+//a stored path never changes: enemies handed the same answer share one copy, and changing a path means storing a
+//new one (copy on write). nothing is refcounted; Collect is given every handle still held, drops the rest and
+//compacts the arena in place, so once the arena has grown to fit the live paths storing one allocates nothing.
+//reads are safe from any thread, Store and Collect are not. decoding only reads the grid's size, which is fixed
+//until the next Init
+class PathPool {
+public:
+    void Init(const GridSystem* grid) {
+        m_Grid = grid;
+        m_Tiles.clear();
+        m_Slots.clear();
+        m_FreeSlots.clear();
+        m_LiveAfterCollect = 0;
+    }
+
+    //tile centers, as the pathfinders return them
+    PathHandle Store(const std::vector<glm::vec3>& waypoints) {
+        return Append(waypoints.size(), [&](size_t i) { return m_Grid->WorldToGrid(waypoints[i]); });
+    }
+
+    PathHandle Store(const std::vector<glm::ivec2>& tiles) {
+        return Append(tiles.size(), [&](size_t i) { return tiles[i]; });
+    }
+
+    PathHandle Store(glm::ivec2 tile) {
+        return Append(1, [&](size_t) { return tile; });
+    }
+
+    //false for the empty path and for handles whose path has been collected
+    bool IsLive(const PathHandle& path) const {
+        return path.slot < m_Slots.size() && m_Slots[path.slot].inUse && m_Slots[path.slot].generation == path.generation;
+    }
+
+    glm::ivec2 GetTile(const PathHandle& path, size_t i) const {
+        int index = static_cast<int>(m_Tiles[m_Slots[path.slot].offset + i]);
+        int width = m_Grid->GetWidth();
+        return { index % width, index / width };
+    }
+
+    glm::vec3 GetWaypoint(const PathHandle& path, size_t i) const {
+        glm::ivec2 tile = GetTile(path, i);
+        return m_Grid->GridToWorld(tile.x, tile.y);
+    }
+
+    //worth collecting once dead paths could make up half the arena
+    bool NeedsCollect() const { return m_Tiles.size() > 2 * m_LiveAfterCollect + COLLECT_SLACK; }
+
+    //forEachHandle(mark) has to call mark(handle) for every path still in use, anything else is freed
+    template<typename ForEachHandle>
+    void Collect(ForEachHandle forEachHandle) {
+        auto start = std::chrono::steady_clock::now();
+        m_Marked.assign(m_Slots.size(), 0);
+        forEachHandle([&](const PathHandle& path) {
+            if (IsLive(path)) m_Marked[path.slot] = 1;
+        });
+
+        m_Order.clear();
+        for (uint32_t slot = 0; slot < m_Slots.size(); ++slot) {
+            Slot& entry = m_Slots[slot];
+            if (!entry.inUse) continue;
+            if (m_Marked[slot]) {
+                m_Order.push_back(slot);
+            }
+            else {
+                entry.inUse = false;
+                ++entry.generation; //outstanding handles to it stop being live
+                m_FreeSlots.push_back(slot);
+            }
+        }
+
+        //slide the survivors down in arena order, every move is towards the front so nothing is overwritten early
+        std::sort(m_Order.begin(), m_Order.end(), [&](uint32_t a, uint32_t b) { return m_Slots[a].offset < m_Slots[b].offset; });
+        uint32_t write = 0;
+        for (uint32_t slot : m_Order) {
+            Slot& entry = m_Slots[slot];
+            std::copy(m_Tiles.begin() + entry.offset, m_Tiles.begin() + entry.offset + entry.length, m_Tiles.begin() + write);
+            entry.offset = write;
+            write += entry.length;
+        }
+        m_Tiles.resize(write);
+        m_LiveAfterCollect = write;
+
+        ++m_Collections;
+        m_LastCollectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    size_t GetLivePaths() const { return m_Slots.size() - m_FreeSlots.size(); }
+    size_t GetArenaTiles() const { return m_Tiles.size(); }
+    size_t GetCollections() const { return m_Collections; }
+    double GetLastCollectMs() const { return m_LastCollectMs; }
+    size_t GetStoredPaths() const { return m_StoredPaths; }
+
+    size_t GetMemoryUsage() const {
+        return m_Tiles.capacity() * sizeof(uint32_t) + m_Slots.capacity() * sizeof(Slot) +
+            m_FreeSlots.capacity() * sizeof(uint32_t) + m_Marked.capacity() + m_Order.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr size_t COLLECT_SLACK = 16384;
+
+    struct Slot {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t generation = 0;
+        bool inUse = false;
+    };
+
+    const GridSystem* m_Grid = nullptr;
+    std::vector<uint32_t> m_Tiles;     //the arena, paths back to back
+    std::vector<Slot> m_Slots;         //PathHandle::slot -> where its tiles are
+    std::vector<uint32_t> m_FreeSlots;
+    size_t m_LiveAfterCollect = 0;
+
+    std::vector<uint8_t> m_Marked;     //Collect scratch, kept so collecting doesn't allocate either
+    std::vector<uint32_t> m_Order;
+
+    size_t m_Collections = 0;
+    double m_LastCollectMs = 0.0;
+    size_t m_StoredPaths = 0;
+
+    template<typename TileAt>
+    PathHandle Append(size_t length, TileAt tileAt) {
+        if (length == 0) return PathHandle();
+        uint32_t slot;
+        if (!m_FreeSlots.empty()) {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else {
+            slot = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.emplace_back();
+        }
+
+        Slot& entry = m_Slots[slot];
+        entry.offset = static_cast<uint32_t>(m_Tiles.size());
+        entry.length = static_cast<uint32_t>(length);
+        entry.inUse = true;
+        int width = m_Grid->GetWidth();
+        for (size_t i = 0; i < length; ++i) {
+            glm::ivec2 tile = tileAt(i);
+            m_Tiles.push_back(static_cast<uint32_t>(tile.y * width + tile.x));
+        }
+        ++m_StoredPaths;
+        return { slot, entry.generation, entry.length };
+    }
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "ECS.h"
+#include "Components.h"
+#include "JobSystem.h"
+#include "Pathfinder.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+struct PathResult {
+    std::vector<glm::vec3> path;        //flat A*: the whole route
+    std::vector<glm::ivec2> coarsePath; //HPA*: entrance tiles, legs get refined on arrival
+
+    //the same answers in the PathPool, filled in on first delivery so every enemy given this result shares them
+    mutable PathHandle pooledPath;
+    mutable PathHandle pooledCoarsePath;
+};
+
+//path searches asked for during one tick and answered in a later one, so a wave spawn spreads its searches over
+//several ticks instead of stalling one. requests with the same start and goal tile share a single search.
+//Process answers the highest priority requests first until the per-tick budget is spent (at least one batch always
+//runs so the queue keeps moving); when the solver is thread safe each batch is spread over the job system.
+//results and requester lists are recycled once nobody holds them any more, so a warmed-up queue solves into
+//buffers that already have the capacity
+class PathRequestService {
+public:
+    void Init(JobSystem* jobs) {
+        m_Jobs = jobs;
+        m_Pending.clear();
+        m_PendingIndex.clear();
+        m_Tickets.clear();
+    }
+
+    //a newer request from the same entity replaces its older one
+    void Submit(ecs::Entity entity, glm::ivec2 start, glm::ivec2 goal, int priority) {
+        uint32_t ticket = ++m_NextTicket;
+        m_Tickets[entity] = ticket;
+
+        uint64_t key = Pathfinder::QueryKey(start, goal);
+        auto it = m_PendingIndex.find(key);
+        if (it != m_PendingIndex.end()) {
+            Request& request = m_Pending[it->second];
+            request.requesters.push_back({ entity, ticket });
+            request.priority = std::max(request.priority, priority);
+            ++m_CoalescedCount;
+            return;
+        }
+        m_PendingIndex[key] = m_Pending.size();
+        m_Pending.push_back({ start, goal, priority, m_NextSequence++, {}, {} });
+        if (!m_SpareRequesters.empty()) {
+            m_Pending.back().requesters = std::move(m_SpareRequesters.back());
+            m_SpareRequesters.pop_back();
+        }
+        m_Pending.back().requesters.push_back({ entity, ticket });
+    }
+
+    void Cancel(ecs::Entity entity) { m_Tickets.erase(entity); }
+    bool IsPending(ecs::Entity entity) const { return m_Tickets.count(entity) != 0; }
+
+    //solve(start, goal, PathResult&) fills in an empty result, then store(start, goal, shared result) once per solved
+    //request and deliver(entity, const PathResult&) for every entity still waiting on it. store and deliver run on
+    //the calling thread, in priority order
+    template<typename Solve, typename Store, typename Deliver>
+    void Process(Solve solve, bool threadSafe, Store store, Deliver deliver) {
+        auto start = std::chrono::steady_clock::now();
+
+        //requests everyone stopped waiting for (cancelled, or asked again with another goal) are dropped unsolved, so
+        //they don't spend the budget the live ones behind them need
+        size_t before = m_Pending.size();
+        m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(), [&](Request& request) {
+            request.requesters.erase(std::remove_if(request.requesters.begin(), request.requesters.end(), [&](const Requester& requester) {
+                return !IsWaiting(requester);
+            }), request.requesters.end());
+            if (!request.requesters.empty()) return false;
+            m_SpareRequesters.push_back(std::move(request.requesters));
+            return true;
+        }), m_Pending.end());
+        m_LastDropped = before - m_Pending.size();
+
+        std::sort(m_Pending.begin(), m_Pending.end(), [](const Request& a, const Request& b) {
+            return a.priority > b.priority || (a.priority == b.priority && a.sequence < b.sequence);
+        });
+
+        bool parallel = threadSafe && m_UseWorkers && m_Jobs;
+        size_t batch = parallel ? m_Jobs->GetActiveWorkers() + 1 : 1;
+        size_t solved = 0;
+        while (solved < m_Pending.size()) {
+            size_t first = solved;
+            size_t count = std::min(batch, m_Pending.size() - first);
+            for (size_t i = first; i < first + count; ++i) {
+                m_Pending[i].result = AcquireResult();
+            }
+            if (parallel) {
+                m_Jobs->ParallelFor(count, [&](size_t begin, size_t end) {
+                    for (size_t i = first + begin; i < first + end; ++i) {
+                        solve(m_Pending[i].start, m_Pending[i].goal, *m_Pending[i].result);
+                    }
+                }, 1);
+            }
+            else {
+                solve(m_Pending[first].start, m_Pending[first].goal, *m_Pending[first].result);
+            }
+            solved += count;
+            if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= m_BudgetMs) break;
+        }
+
+        for (size_t i = 0; i < solved; ++i) {
+            store(m_Pending[i].start, m_Pending[i].goal, m_Pending[i].result);
+            for (auto const& requester : m_Pending[i].requesters) {
+                if (!IsWaiting(requester)) continue; //cancelled by an earlier deliver
+                m_Tickets.erase(requester.entity);
+                deliver(requester.entity, *m_Pending[i].result);
+            }
+        }
+
+        for (size_t i = 0; i < solved; ++i) {
+            m_Pending[i].requesters.clear();
+            m_SpareRequesters.push_back(std::move(m_Pending[i].requesters));
+        }
+        m_Pending.erase(m_Pending.begin(), m_Pending.begin() + solved);
+        m_PendingIndex.clear();
+        for (size_t i = 0; i < m_Pending.size(); ++i) {
+            m_PendingIndex[Pathfinder::QueryKey(m_Pending[i].start, m_Pending[i].goal)] = i;
+        }
+
+        m_LastSolved = solved;
+        m_LastProcessMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void SetBudgetMs(double budgetMs) { m_BudgetMs = budgetMs; }
+    double GetBudgetMs() const { return m_BudgetMs; }
+    void SetUseWorkers(bool useWorkers) { m_UseWorkers = useWorkers; }
+    bool GetUseWorkers() const { return m_UseWorkers; }
+
+    size_t GetPendingCount() const { return m_Pending.size(); }
+    size_t GetLastSolved() const { return m_LastSolved; }
+    size_t GetLastDropped() const { return m_LastDropped; }
+    double GetLastProcessMs() const { return m_LastProcessMs; }
+    size_t GetCoalescedCount() const { return m_CoalescedCount; }
+
+private:
+    struct Requester {
+        ecs::Entity entity;
+        uint32_t ticket;
+    };
+
+    struct Request {
+        glm::ivec2 start, goal;
+        int priority;
+        uint64_t sequence; //submission order, breaks priority ties
+        std::vector<Requester> requesters;
+        std::shared_ptr<PathResult> result;
+    };
+
+    JobSystem* m_Jobs = nullptr;
+    std::vector<Request> m_Pending;
+    std::unordered_map<uint64_t, size_t> m_PendingIndex;  //Pathfinder::QueryKey(start, goal) -> slot in m_Pending
+    std::unordered_map<ecs::Entity, uint32_t> m_Tickets;  //latest request of every waiting entity
+    std::vector<std::vector<Requester>> m_SpareRequesters; //emptied lists of finished requests, capacity kept
+    std::vector<std::shared_ptr<PathResult>> m_Results;    //every result handed out, reused once only this holds it
+    size_t m_ResultCursor = 0;
+    uint32_t m_NextTicket = 0;
+    uint64_t m_NextSequence = 0;
+
+    double m_BudgetMs = 2.0;
+    bool m_UseWorkers = true;
+    size_t m_LastSolved = 0;
+    size_t m_LastDropped = 0;
+    double m_LastProcessMs = 0.0;
+    size_t m_CoalescedCount = 0;
+
+    //a result the cache has let go of and no request still points at, emptied, or a new one once all are in use
+    std::shared_ptr<PathResult> AcquireResult() {
+        for (size_t n = 0; n < m_Results.size(); ++n) {
+            m_ResultCursor = (m_ResultCursor + 1) % m_Results.size();
+            std::shared_ptr<PathResult>& result = m_Results[m_ResultCursor];
+            if (result.use_count() != 1) continue;
+            result->path.clear();
+            result->coarsePath.clear();
+            result->pooledPath.Clear();
+            result->pooledCoarsePath.Clear();
+            return result;
+        }
+        m_Results.push_back(std::make_shared<PathResult>());
+        return m_Results.back();
+    }
+
+    bool IsWaiting(const Requester& requester) const {
+        auto ticket = m_Tickets.find(requester.entity);
+        return ticket != m_Tickets.end() && ticket->second == requester.ticket;
+    }
+};
@@ -1,98 +1,232 @@
 #pragma once
 
 #include <vector>
-#include <queue>
-#include <unordered_map>
-#include <set>
 #include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
 #include <glm/glm.hpp>
-#include <glm/gtx/hash.hpp> 
 #include "GridSystem.h"
 
 namespace Pathfinder {
 
-    struct Node {
-        glm::ivec2 pos;
-        float gCost = FLT_MAX;
-        float hCost = 0.0f;
-        float fCost = FLT_MAX;
-        glm::ivec2 parent;
-        bool inOpenSet = false;
-        bool inClosedSet = false;
-
-        Node(glm::ivec2 p = { 0,0 }) : pos(p) {}
-        bool operator>(const Node& other) const { return fCost > other.fCost; }
+    struct QueryStats {
+        size_t nodesExpanded = 0;
+        double ms = 0.0;
     };
 
-    inline float CalculateHeuristic(const glm::ivec2& a, const glm::ivec2& b) {
-        return static_cast<float>(std::abs(a.x - b.x) + std::abs(a.y - b.y));
+    inline int CalculateHeuristic(const glm::ivec2& a, const glm::ivec2& b) {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
     }
 
-    inline std::vector<glm::vec3> FindPath(GridSystem* gridSystem, glm::ivec2 start, glm::ivec2 end) {
-        std::vector<glm::vec3> path;
-        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> openSet;
-        std::unordered_map<glm::ivec2, Node> allNodes;
+    //one query as a map key, 16 bits per coordinate. the request queue coalesces on it and the path cache looks
+    //answers up by it, so both have to agree on what counts as the same search
+    inline uint64_t QueryKey(glm::ivec2 start, glm::ivec2 goal) {
+        return (uint64_t(uint16_t(start.x)) << 48) | (uint64_t(uint16_t(start.y)) << 32) |
+            (uint64_t(uint16_t(goal.x)) << 16) | uint64_t(uint16_t(goal.y));
+    }
+
+    //A* scratch space sized to the grid and reused between queries. node records are indexed by tile and only
+    //count as touched when their generation matches the current query, so starting a search is O(1) instead of
+    //clearing the arrays. the open set is a binary heap of tile indices that knows each tile's slot, so a cheaper
+    //route to a tile already in it is a sift-up rather than a duplicate push.
+    //one context is not thread safe; use ThreadContext() to get one per thread
+    class PathfinderContext {
+    public:
+        //4-way, unit cost, manhattan heuristic. the end tile may be occupied (it is usually the building being
+        //attacked). returns tile centers from start to end, or nothing if end can't be reached
+        std::vector<glm::vec3> FindPath(const GridSystem* grid, glm::ivec2 start, glm::ivec2 end) {
+            std::vector<glm::vec3> path;
+            FindPath(grid, start, end, path);
+            return path;
+        }
+
+        //same, written over `path` so a caller that keeps its buffer doesn't allocate once the buffer has grown
+        void FindPath(const GridSystem* grid, glm::ivec2 start, glm::ivec2 end, std::vector<glm::vec3>& path) {
+            auto startTime = std::chrono::steady_clock::now();
+            path.clear();
+            m_LastStats.nodesExpanded = 0;
+
+            if (grid->IsValidTile(start.x, start.y) && grid->IsValidTile(end.x, end.y)) {
+                BeginQuery(grid);
+                int endIndex = TileIndex(end.x, end.y);
+                if (Search(grid, start, end)) {
+                    for (int index = endIndex; index != NO_PARENT; index = m_Nodes[index].parent) {
+                        path.push_back(grid->GridToWorld(index % m_Width, index / m_Width));
+                    }
+                    std::reverse(path.begin(), path.end());
+                }
+            }
 
-        Node startNode(start);
-        startNode.gCost = 0.0f;
-        startNode.hCost = CalculateHeuristic(start, end);
-        startNode.fCost = startNode.hCost;
-        startNode.inOpenSet = true;
+            m_LastStats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        }
 
-        openSet.push(startNode);
-        allNodes[start] = startNode;
+        const QueryStats& GetLastStats() const { return m_LastStats; }
+
+        size_t GetMemoryUsage() const {
+            return m_Nodes.capacity() * sizeof(NodeRecord) + m_Heap.capacity() * sizeof(int);
+        }
 
-        const std::array<glm::ivec2, 4> neighbors = {
-            glm::ivec2(0, 1), glm::ivec2(0, -1), glm::ivec2(1, 0), glm::ivec2(-1, 0)
+    private:
+        static constexpr int NO_PARENT = -1;
+        static constexpr int CLOSED = -1; //heapSlot of an expanded node
+
+        struct NodeRecord {
+            uint32_t generation = 0; //record is stale unless this matches m_Generation
+            int gCost = 0;
+            int fCost = 0;
+            int parent = NO_PARENT;
+            int heapSlot = CLOSED;
         };
 
-        while (!openSet.empty()) {
-            Node currentNode = openSet.top();
-            openSet.pop();
+        std::vector<NodeRecord> m_Nodes;
+        std::vector<int> m_Heap;
+        uint32_t m_Generation = 0;
+        int m_Width = 0;
+        QueryStats m_LastStats;
 
-            currentNode.inOpenSet = false;
-            currentNode.inClosedSet = true;
-            allNodes[currentNode.pos] = currentNode;
+        int TileIndex(int x, int y) const { return y * m_Width + x; }
 
-            if (currentNode.pos == end) {
-                glm::ivec2 current = end;
-                while (current != start) {
-                    path.push_back(gridSystem->GridToWorld(current.x, current.y));
-                    current = allNodes[current].parent;
-                }
-                path.push_back(gridSystem->GridToWorld(start.x, start.y));
-                std::reverse(path.begin(), path.end());
-                return path;
+        void BeginQuery(const GridSystem* grid) {
+            size_t tileCount = static_cast<size_t>(grid->GetWidth()) * static_cast<size_t>(grid->GetHeight());
+            m_Width = grid->GetWidth();
+            if (m_Nodes.size() != tileCount || ++m_Generation == 0) {
+                m_Nodes.assign(tileCount, NodeRecord{});
+                m_Generation = 1;
             }
+            m_Heap.clear();
+        }
 
-            for (const auto& dir : neighbors) {
-                glm::ivec2 neighborPos = currentNode.pos + dir;
+        bool Search(const GridSystem* grid, glm::ivec2 start, glm::ivec2 end) {
+            static const glm::ivec2 neighbors[4] = {
+                glm::ivec2(0, 1), glm::ivec2(0, -1), glm::ivec2(1, 0), glm::ivec2(-1, 0)
+            };
+            int startIndex = TileIndex(start.x, start.y);
+            int endIndex = TileIndex(end.x, end.y);
+
+            NodeRecord& startNode = m_Nodes[startIndex];
+            startNode = { m_Generation, 0, CalculateHeuristic(start, end), NO_PARENT, CLOSED };
+            Push(startIndex);
+
+            while (!m_Heap.empty()) {
+                int current = Pop();
+                ++m_LastStats.nodesExpanded;
+                if (current == endIndex) return true;
+
+                glm::ivec2 pos(current % m_Width, current / m_Width);
+                int newGCost = m_Nodes[current].gCost + 1;
+                for (const auto& dir : neighbors) {
+                    glm::ivec2 neighborPos = pos + dir;
+                    if (neighborPos != end && !grid->IsWalkable(neighborPos.x, neighborPos.y)) {
+                        continue;
+                    }
 
-                if (neighborPos != end && !gridSystem->IsWalkable(neighborPos.x, neighborPos.y)) {
-                    continue;
+                    int neighbor = TileIndex(neighborPos.x, neighborPos.y);
+                    NodeRecord& node = m_Nodes[neighbor];
+                    if (node.generation != m_Generation) {
+                        node = { m_Generation, newGCost, newGCost + CalculateHeuristic(neighborPos, end), current, CLOSED };
+                        Push(neighbor);
+                    }
+                    else if (node.heapSlot != CLOSED && newGCost < node.gCost) {
+                        node.fCost -= node.gCost - newGCost;
+                        node.gCost = newGCost;
+                        node.parent = current;
+                        SiftUp(node.heapSlot);
+                    }
                 }
+            }
+            return false;
+        }
+
+        //lower f first; on equal f prefer the deeper node, it is closer to the goal
+        bool Before(int a, int b) const {
+            const NodeRecord& na = m_Nodes[a];
+            const NodeRecord& nb = m_Nodes[b];
+            return na.fCost < nb.fCost || (na.fCost == nb.fCost && na.gCost > nb.gCost);
+        }
 
-                if (allNodes.count(neighborPos) && allNodes[neighborPos].inClosedSet) continue;
+        void Place(int slot, int index) {
+            m_Heap[slot] = index;
+            m_Nodes[index].heapSlot = slot;
+        }
 
-                float newGCost = currentNode.gCost + 1.0f;
-                Node& neighborNode = allNodes[neighborPos];
+        void Push(int index) {
+            m_Heap.push_back(index);
+            SiftUp(static_cast<int>(m_Heap.size()) - 1);
+        }
+
+        int Pop() {
+            int top = m_Heap.front();
+            int last = m_Heap.back();
+            m_Heap.pop_back();
+            if (!m_Heap.empty()) {
+                Place(0, last);
+                SiftDown(0);
+            }
+            m_Nodes[top].heapSlot = CLOSED;
+            return top;
+        }
 
-                if (newGCost < neighborNode.gCost) {
-                    neighborNode.pos = neighborPos;
-                    neighborNode.parent = currentNode.pos;
-                    neighborNode.gCost = newGCost;
-                    neighborNode.hCost = CalculateHeuristic(neighborPos, end);
-                    neighborNode.fCost = neighborNode.gCost + neighborNode.hCost;
+        void SiftUp(int slot) {
+            int index = m_Heap[slot];
+            while (slot > 0) {
+                int parent = (slot - 1) / 2;
+                if (!Before(index, m_Heap[parent])) break;
+                Place(slot, m_Heap[parent]);
+                slot = parent;
+            }
+            Place(slot, index);
+        }
 
-                    if (!neighborNode.inOpenSet) {
-                        openSet.push(neighborNode);
-                        neighborNode.inOpenSet = true;
-                    }
-                }
+        void SiftDown(int slot) {
+            int index = m_Heap[slot];
+            int count = static_cast<int>(m_Heap.size());
+            while (true) {
+                int child = slot * 2 + 1;
+                if (child >= count) break;
+                if (child + 1 < count && Before(m_Heap[child + 1], m_Heap[child])) ++child;
+                if (!Before(m_Heap[child], index)) break;
+                Place(slot, m_Heap[child]);
+                slot = child;
             }
+            Place(slot, index);
         }
+    };
+
+    //longest straight run SmoothPath will check, keeps open stretches from costing quadratic time
+    constexpr size_t MAX_SHORTCUT = 32;
+
+    //string pulling, in place: every waypoint the unit can skip by walking straight at a later one is dropped. a
+    //shortcut is only taken when GridSystem::IsLineWalkable allows it, the last waypoint may be occupied
+    inline void SmoothPath(const GridSystem* grid, std::vector<glm::vec3>& path) {
+        if (path.size() < 3) return;
+        size_t kept = 1;
+        size_t anchor = 0;
+        glm::ivec2 anchorTile = grid->WorldToGrid(path[0]);
+        while (anchor + 1 < path.size()) {
+            size_t furthest = anchor + 1;
+            for (size_t next = anchor + 2; next < path.size() && next - anchor <= MAX_SHORTCUT; ++next) {
+                if (!grid->IsLineWalkable(anchorTile, grid->WorldToGrid(path[next]), next + 1 == path.size())) break;
+                furthest = next;
+            }
+            path[kept++] = path[furthest]; //kept never passes furthest, so nothing still to be read is overwritten
+            anchor = furthest;
+            anchorTile = grid->WorldToGrid(path[furthest]);
+        }
+        path.resize(kept);
+    }
+
+    inline PathfinderContext& ThreadContext() {
+        thread_local PathfinderContext context;
+        return context;
+    }
+
+    inline std::vector<glm::vec3> FindPath(const GridSystem* gridSystem, glm::ivec2 start, glm::ivec2 end) {
+        return ThreadContext().FindPath(gridSystem, start, end);
+    }
 
-        return path; //if no path fpund
+    inline void FindPath(const GridSystem* gridSystem, glm::ivec2 start, glm::ivec2 end, std::vector<glm::vec3>& path) {
+        ThreadContext().FindPath(gridSystem, start, end, path);
     }
 
-}
\ No newline at end of file
+}
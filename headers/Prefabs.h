@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ECS.h"
+#include "Components.h"
+#include "Constants.h"
+
+//component layouts for everything the game spawns; per-instance values (position, velocity...) go through the Spawn initializer
+namespace Prefabs {
+
+    inline const ecs::Prefab& Enemy() {
+        static const ecs::Prefab prefab = []() {
+            MovementComponent movement;
+            movement.speed = 3.0f;
+            return ecs::Prefab()
+                .With(TransformComponent{ {0.0f, 0.0f, 0.0f}, glm::vec3{0.12f}, {0.0f, 0.0f, 0.0f} })
+                .With(RenderComponent{ {0.8f, 0.2f, 0.8f, 1.0f} })
+                .With(MeshComponent{ MeshType::Cube })
+                .With(HealthComponent{ 50, 50 })
+                .With(EnemyComponent{})
+                .With(CollisionComponent{ 0.4f })
+                .With(movement);
+        }();
+        return prefab;
+    }
+
+    inline const ecs::Prefab& Projectile() {
+        static const ecs::Prefab prefab = ecs::Prefab()
+            .With(TransformComponent{ {0.0f, 0.0f, 0.0f}, {0.2f, 0.2f, 0.2f}, {0.0f, 0.0f, 0.0f} })
+            .With(RenderComponent{ {1.0f, 0.5f, 0.0f, 1.0f} }) //orange
+            .With(MeshComponent{ MeshType::Sphere })
+            .With(ProjectileComponent{ {0.0f, 0.0f, 0.0f}, 4 }); //4 damage
+        return prefab;
+    }
+
+    inline const ecs::Prefab& Base() {
+        static const ecs::Prefab prefab = ecs::Prefab()
+            .With(TransformComponent{})
+            .With(RenderComponent{ {1.0f, 1.0f, 1.0f, 1.0f} })
+            .With(MeshComponent{ MeshType::Base })
+            .With(BuildingComponent{ BuildingType::Base })
+            .With(CollisionComponent{ 0.5f })
+            .With(HealthComponent{ baseHealth, baseHealth });
+        return prefab;
+    }
+
+    inline const ecs::Prefab& ResourceNode() {
+        static const ecs::Prefab prefab = ecs::Prefab()
+            .With(TransformComponent{})
+            .With(RenderComponent{ {0.2f, 0.8f, 0.2f, 1.0f} })
+            .With(MeshComponent{ MeshType::Cube })
+            .With(BuildingComponent{ BuildingType::ResourceNode })
+            .With(CollisionComponent{ 0.5f })
+            .With(ResourceGeneratorComponent{})
+            .With(HealthComponent{ resourceNodeHealth, resourceNodeHealth });
+        return prefab;
+    }
+
+    inline const ecs::Prefab& Turret() {
+        static const ecs::Prefab prefab = ecs::Prefab()
+            .With(TransformComponent{})
+            .With(RenderComponent{ {1.0f, 1.0f, 1.0f, 1.0f} })
+            .With(MeshComponent{ MeshType::Turret })
+            .With(BuildingComponent{ BuildingType::Turret })
+            .With(CollisionComponent{ 0.5f })
+            .With(TurretAIComponent{})
+            .With(HealthComponent{ turretHealth, turretHealth });
+        return prefab;
+    }
+
+    inline const ecs::Prefab& Bomb() {
+        static const ecs::Prefab prefab = ecs::Prefab()
+            .With(TransformComponent{})
+            .With(RenderComponent{ {1.0f, 1.0f, 1.0f, 1.0f} })
+            .With(MeshComponent{ MeshType::Sphere })
+            .With(BuildingComponent{ BuildingType::Bomb })
+            .With(CollisionComponent{ 0.5f })
+            .With(BombComponent{})
+            .With(HealthComponent{ bombHealth, bombHealth });
+        return prefab;
+    }
+
+    inline const ecs::Prefab* ForBuilding(BuildingType type) {
+        switch (type) {
+        case BuildingType::Base: return &Base();
+        case BuildingType::ResourceNode: return &ResourceNode();
+        case BuildingType::Turret: return &Turret();
+        case BuildingType::Bomb: return &Bomb();
+        default: return nullptr;
+        }
+    }
+
+}
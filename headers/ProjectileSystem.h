@@ -3,23 +3,37 @@
 
 #include "ECS.h"
 #include "Components.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "SpatialHashSystem.h"
+#include "GridSystem.h"
 #include <glm/glm.hpp>
 #include <set>
 
 class ProjectileSystem : public ecs::System {
 public:
-    void Update(float dt, ecs::Registry* registry, const std::set<ecs::Entity>& allEnemies) {
-        std::set<ecs::Entity> bulletsToDestroy;
+    void Init(GridSystem* grid, JobSystem* jobs, SpatialHashSystem* spatial) {
+        m_GridSystem = grid;
+        m_Jobs = jobs;
+        m_Spatial = spatial;
+    }
 
-        // 1. Move all projectiles
-        for (auto const& entity : m_Entities) {
-            auto& transform = m_Registry->GetComponent<TransformComponent>(entity);
-            auto& projectile = m_Registry->GetComponent<ProjectileComponent>(entity);
+    void Update(float dt, ecs::Registry* registry) {
+        std::set<ecs::Entity> bulletsToDestroy;
+        auto projectiles = registry->View<ProjectileComponent, TransformComponent>();
 
-            transform.position += projectile.velocity * dt;
+        // 1. Move all projectiles (each bullet only touches itself, so this is split across workers)
+        m_Jobs->ParallelFor(projectiles.SizeHint(), [&](size_t begin, size_t end) {
+            projectiles.EachInRange(begin, end, [&](ecs::Entity, ProjectileComponent& projectile, TransformComponent& transform) {
+                transform.position += projectile.velocity * dt;
+            });
+        }, 1024);
 
-            // 2. Check for collision
-            for (auto const& enemy : allEnemies) {
+        projectiles.Each([&](ecs::Entity entity, ProjectileComponent& projectile, TransformComponent& transform) {
+            // 2. Check for collision against the enemies hashed near the bullet
+            bool hit = false;
+            m_Spatial->GetEnemies().QueryRadius(transform.position, 1.0f, [&](ecs::Entity enemy, const glm::vec3&) {
+                if (hit || !registry->HasComponent<HealthComponent>(enemy)) return; // Bullet can only hit one target
                 auto& enemyT = registry->GetComponent<TransformComponent>(enemy);
 
                 // Simple sphere-to-sphere collision
@@ -29,19 +43,33 @@ public:
                     health.currentHP -= projectile.damage;
                     std::cout << "Projectile " << entity << " hit Enemy " << enemy << "! HP: " << health.currentHP << std::endl;
                     bulletsToDestroy.insert(entity);
-                    break; // Bullet can only hit one target
+                    hit = true;
                 }
-            }
+            });
 
-            // 3. Check for out-of-bounds (despawn)
-            if (glm::length(transform.position) > 50.0f) {
+            // 3. Check for out-of-bounds (despawn): off the map, or sunk far enough into the floor that no enemy is in reach
+            glm::ivec2 tile = m_GridSystem->WorldToGrid(transform.position);
+            if (!m_GridSystem->IsValidTile(tile.x, tile.y) || transform.position.y < -1.0f) {
                 bulletsToDestroy.insert(entity);
             }
-        }
+        });
 
-        // 4. Destroy all used bullets
+        // 4. Destroy all used bullets at the next sync point
         for (auto const& bullet : bulletsToDestroy) {
-            registry->DestroyEntity(bullet);
+            m_Commands.DestroyEntity(bullet);
         }
     }
+
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess()
+            .Read<ProjectileComponent, EnemyComponent>()
+            .Write<TransformComponent, HealthComponent>()
+            .ReadResource<SpatialHashSystem>()
+            .ReadResource<GridSystem>();
+    }
+
+private:
+    GridSystem* m_GridSystem = nullptr;
+    JobSystem* m_Jobs = nullptr;
+    SpatialHashSystem* m_Spatial = nullptr;
 };
\ No newline at end of file
@@ -45,11 +45,11 @@ public:
         m_Shader.SetMat4("view", view);
         glDepthMask(GL_TRUE);
 
-        for (auto const& entity : m_Entities) {
-            if (registry->HasComponent<GhostComponent>(entity)) continue;
-            RenderEntity(registry, entity, m_Shader);
-            m_TotalRendered++;
-        }
+        registry->View<TransformComponent, RenderComponent, MeshComponent>(ecs::Exclude<GhostComponent>).Each(
+            [&](ecs::Entity, TransformComponent& transform, RenderComponent& render, MeshComponent& meshComp) {
+                RenderEntity(transform, render, meshComp, m_Shader);
+                m_TotalRendered++;
+            });
 
         //ghost objects (highlighter)
         glDepthMask(GL_FALSE);
@@ -57,9 +57,10 @@ public:
         m_GhostShader.SetMat4("projection", projection);
         m_GhostShader.SetMat4("view", view);
 
-        for (auto const& entity : registry->GetSystem<InputSystem>()->m_Entities) {
-            RenderEntity(registry, entity, m_GhostShader);
-        }
+        registry->View<GhostComponent, TransformComponent, RenderComponent, MeshComponent>().Each(
+            [&](ecs::Entity, GhostComponent&, TransformComponent& transform, RenderComponent& render, MeshComponent& meshComp) {
+                RenderEntity(transform, render, meshComp, m_GhostShader);
+            });
         glDepthMask(GL_TRUE);
     }
 
@@ -68,12 +69,8 @@ private:
     Shader m_GhostShader;
     std::map<MeshType, std::shared_ptr<Mesh>> m_Meshes;
 
-    void RenderEntity(ecs::Registry* registry, ecs::Entity entity, Shader& shader)
+    void RenderEntity(const TransformComponent& transform, const RenderComponent& render, const MeshComponent& meshComp, Shader& shader)
     {
-        auto& transform = registry->GetComponent<TransformComponent>(entity);
-        auto& render = registry->GetComponent<RenderComponent>(entity);
-        auto& meshComp = registry->GetComponent<MeshComponent>(entity);
-
         if (meshComp.type == MeshType::None) return;
         auto it = m_Meshes.find(meshComp.type);
         if (it == m_Meshes.end()) return;
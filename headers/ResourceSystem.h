@@ -4,6 +4,7 @@
 #include "ECS.h"
 #include "Components.h"
 #include "BalanceSystem.h" 
+#include "Scheduler.h"
 #include <iostream>
 
 class ResourceSystem : public ecs::System {
@@ -16,10 +17,13 @@ public:
     void Update(float dt) {
         float modifier = m_BalanceSystem->GetResourceModifier();
 
-        for (auto const& entity : m_Entities) {
-            auto& generator = m_Registry->GetComponent<ResourceGeneratorComponent>(entity);
+        m_Registry->View<ResourceGeneratorComponent>().Each([&](ecs::Entity, ResourceGeneratorComponent& generator) {
             m_CurrentResources += generator.resourcesPerSecond * modifier * dt;
-        }
+        });
+    }
+
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess().Read<ResourceGeneratorComponent>().ReadResource<BalanceSystem>().WriteResource<ResourceSystem>();
     }
 
     double GetResources() const {
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ECS.h"
+#include "JobSystem.h"
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace ecs {
+
+    //shared state that is not a component (grid, resource counter, balance...) gets its own id space,
+    //keyed by whatever type owns it
+    using ResourceTypeID = uint8_t;
+    constexpr ResourceTypeID MAX_RESOURCES = 32;
+    using ResourceSet = std::bitset<MAX_RESOURCES>;
+
+    inline ResourceTypeID NextResourceTypeID() {
+        static ResourceTypeID next = 0;
+        return next++;
+    }
+    template<typename T>
+    ResourceTypeID ResourceType() {
+        static const ResourceTypeID id = NextResourceTypeID();
+        return id;
+    }
+
+    //what a system touches during its update. two systems conflict when one writes something the other reads or writes
+    class SystemAccess {
+    public:
+        template<typename... Ts>
+        SystemAccess& Read() { (m_ComponentReads.set(ComponentType<Ts>()), ...); return *this; }
+        template<typename... Ts>
+        SystemAccess& Write() { (m_ComponentWrites.set(ComponentType<Ts>()), ...); return *this; }
+        template<typename... Ts>
+        SystemAccess& ReadResource() { (m_ResourceReads.set(ResourceType<Ts>()), ...); return *this; }
+        template<typename... Ts>
+        SystemAccess& WriteResource() { (m_ResourceWrites.set(ResourceType<Ts>()), ...); return *this; }
+
+        bool ConflictsWith(const SystemAccess& other) const {
+            Signature components = m_ComponentReads | m_ComponentWrites;
+            Signature otherComponents = other.m_ComponentReads | other.m_ComponentWrites;
+            ResourceSet resources = m_ResourceReads | m_ResourceWrites;
+            ResourceSet otherResources = other.m_ResourceReads | other.m_ResourceWrites;
+            return (m_ComponentWrites & otherComponents).any() || (other.m_ComponentWrites & components).any() ||
+                   (m_ResourceWrites & otherResources).any() || (other.m_ResourceWrites & resources).any();
+        }
+
+    private:
+        Signature m_ComponentReads{}, m_ComponentWrites{};
+        ResourceSet m_ResourceReads{}, m_ResourceWrites{};
+    };
+
+
+    //runs a fixed list of updates once per tick. systems are added in their serial order; each one waits for every
+    //earlier system it conflicts with, so any schedule the job system produces gives the same result as running the
+    //list top to bottom. systems that ParallelFor internally share the same workers. structural changes still have
+    //to go through the systems' command buffers
+    class Scheduler {
+    public:
+        struct Entry {
+            std::string name;
+            SystemAccess access;
+            std::function<void()> run;
+            std::vector<size_t> dependencies; //earlier entries this one has to wait for
+            size_t stage = 0;                 //longest dependency chain in front of this entry
+            double lastMs = 0.0;
+        };
+
+        explicit Scheduler(JobSystem* jobs) : m_Jobs(jobs) {}
+
+        void Add(const std::string& name, SystemAccess access, std::function<void()> run) {
+            Entry entry;
+            entry.name = name;
+            entry.access = access;
+            entry.run = std::move(run);
+            size_t index = m_Entries.size();
+            for (size_t i = 0; i < index; ++i) {
+                if (m_Entries[i].access.ConflictsWith(access)) {
+                    entry.dependencies.push_back(i);
+                    entry.stage = std::max(entry.stage, m_Entries[i].stage + 1);
+                }
+            }
+            m_Entries.push_back(std::move(entry));
+        }
+
+        void Run() {
+            auto start = std::chrono::steady_clock::now();
+            if (m_Parallel && m_Jobs) {
+                RunParallel();
+            }
+            else {
+                for (size_t i = 0; i < m_Entries.size(); ++i) RunEntry(i);
+            }
+            m_LastTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void SetParallel(bool parallel) { m_Parallel = parallel; }
+        bool IsParallel() const { return m_Parallel; }
+        const std::vector<Entry>& GetEntries() const { return m_Entries; }
+        double GetLastTickMs() const { return m_LastTickMs; }
+
+    private:
+        JobSystem* m_Jobs;
+        std::vector<Entry> m_Entries;
+        bool m_Parallel = true;
+        double m_LastTickMs = 0.0;
+
+        void RunEntry(size_t index) {
+            auto start = std::chrono::steady_clock::now();
+            m_Entries[index].run();
+            m_Entries[index].lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void RunParallel() {
+            std::vector<JobSystem::JobHandle> jobs(m_Entries.size());
+            for (size_t i = 0; i < m_Entries.size(); ++i) {
+                std::vector<JobSystem::JobHandle> dependencies;
+                for (size_t dependency : m_Entries[i].dependencies) {
+                    dependencies.push_back(jobs[dependency]);
+                }
+                jobs[i] = m_Jobs->Schedule([this, i]() { RunEntry(i); }, dependencies);
+            }
+            m_Jobs->WaitAll(jobs);
+        }
+    };
+
+}
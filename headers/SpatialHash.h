@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ECS.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+//uniform grid over the XZ plane, hashed into a power-of-two bucket table so it covers unbounded space without a fixed extent.
+//built in bulk: Clear, Insert every point, then Build counting-sorts the points by bucket so each bucket is one contiguous run.
+//queries hand out the stored (snapshot) position; callers that need exact tests should re-read the live transform
+class SpatialHash {
+public:
+    struct Entry {
+        ecs::Entity entity;
+        glm::vec3 position;
+        glm::ivec2 cell;
+    };
+
+    explicit SpatialHash(float cellSize = 2.0f) : m_CellSize(cellSize) {}
+
+    void Clear() {
+        m_Pending.clear();
+        m_Entries.clear();
+        m_BucketStart.assign(2, 0);
+        m_BucketMask = 0;
+    }
+
+    void Insert(ecs::Entity entity, const glm::vec3& position) {
+        m_Pending.push_back({ entity, position, CellOf(position) });
+    }
+
+    void Build() {
+        uint32_t buckets = 64;
+        while (buckets < m_Pending.size() * 2) buckets <<= 1;
+        m_BucketMask = buckets - 1;
+
+        m_BucketStart.assign(buckets + 1, 0);
+        for (auto const& entry : m_Pending) {
+            ++m_BucketStart[Bucket(entry.cell) + 1];
+        }
+        for (uint32_t i = 0; i < buckets; ++i) {
+            m_BucketStart[i + 1] += m_BucketStart[i];
+        }
+
+        //stable, so points within a bucket keep insertion order and queries stay deterministic
+        m_Entries.resize(m_Pending.size());
+        std::vector<uint32_t> cursor(m_BucketStart.begin(), m_BucketStart.end() - 1);
+        for (auto const& entry : m_Pending) {
+            m_Entries[cursor[Bucket(entry.cell)]++] = entry;
+        }
+        m_Pending.clear();
+    }
+
+    size_t Size() const { return m_Entries.size(); }
+    float GetCellSize() const { return m_CellSize; }
+
+    glm::ivec2 CellOf(const glm::vec3& position) const {
+        return { static_cast<int>(std::floor(position.x / m_CellSize)), static_cast<int>(std::floor(position.z / m_CellSize)) };
+    }
+
+    //func(entity, position) for every point stored in the cell
+    template<typename Func>
+    void QueryCell(glm::ivec2 cell, Func func) const {
+        if (m_Entries.empty()) return;
+        uint32_t bucket = Bucket(cell);
+        for (uint32_t i = m_BucketStart[bucket]; i < m_BucketStart[bucket + 1]; ++i) {
+            const Entry& entry = m_Entries[i];
+            if (entry.cell == cell) func(entry.entity, entry.position);
+        }
+    }
+
+    //func(entity, position) for every point within radius of center on the XZ plane
+    template<typename Func>
+    void QueryRadius(const glm::vec3& center, float radius, Func func) const {
+        if (m_Entries.empty()) return;
+        glm::ivec2 min = CellOf(center - glm::vec3(radius, 0.0f, radius));
+        glm::ivec2 max = CellOf(center + glm::vec3(radius, 0.0f, radius));
+        float radiusSq = radius * radius;
+
+        for (int x = min.x; x <= max.x; ++x) {
+            for (int z = min.y; z <= max.y; ++z) {
+                QueryCell({ x, z }, [&](ecs::Entity entity, const glm::vec3& position) {
+                    float dx = position.x - center.x;
+                    float dz = position.z - center.z;
+                    if (dx * dx + dz * dz <= radiusSq) func(entity, position);
+                });
+            }
+        }
+    }
+
+    size_t GetMemoryUsage() const {
+        return m_Pending.capacity() * sizeof(Entry) + m_Entries.capacity() * sizeof(Entry) +
+            m_BucketStart.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    float m_CellSize;
+    std::vector<Entry> m_Pending;         //inserted since the last Build
+    std::vector<Entry> m_Entries;         //grouped by bucket
+    std::vector<uint32_t> m_BucketStart = std::vector<uint32_t>(2, 0); //bucket b owns [start[b], start[b+1])
+    uint32_t m_BucketMask = 0;
+
+    uint32_t Bucket(glm::ivec2 cell) const {
+        uint32_t hash = (static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u);
+        return hash & m_BucketMask;
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ECS.h"
+#include "Components.h"
+#include "SpatialHash.h"
+#include "Scheduler.h"
+#include <algorithm>
+
+//rebuilds the enemy and building hashes at the start of every tick so the other systems can do neighbour queries.
+//positions are a snapshot: systems that run after MovementSystem pad their query radius by MOVEMENT_SLACK
+class SpatialHashSystem : public ecs::System {
+public:
+    static constexpr float MOVEMENT_SLACK = 0.25f;
+
+    void Update(ecs::Registry* registry) {
+        m_Enemies.Clear();
+        m_MaxEnemyRadius = 0.0f;
+        registry->View<EnemyComponent, TransformComponent>().Each([&](ecs::Entity entity, EnemyComponent&, TransformComponent& transform) {
+            m_Enemies.Insert(entity, transform.position);
+            if (registry->HasComponent<CollisionComponent>(entity)) {
+                m_MaxEnemyRadius = std::max(m_MaxEnemyRadius, registry->GetComponent<CollisionComponent>(entity).radius);
+            }
+        });
+        m_Enemies.Build();
+
+        //collision against buildings goes through the grid, this one is for area queries
+        m_Buildings.Clear();
+        registry->View<BuildingComponent, TransformComponent>().Each([&](ecs::Entity entity, BuildingComponent&, TransformComponent& transform) {
+            m_Buildings.Insert(entity, transform.position);
+        });
+        m_Buildings.Build();
+    }
+
+    const SpatialHash& GetEnemies() const { return m_Enemies; }
+    const SpatialHash& GetBuildings() const { return m_Buildings; }
+    float GetMaxEnemyRadius() const { return m_MaxEnemyRadius; }
+
+    size_t GetMemoryUsage() const { return m_Enemies.GetMemoryUsage() + m_Buildings.GetMemoryUsage(); }
+
+    ecs::SystemAccess GetAccess() const {
+        return ecs::SystemAccess()
+            .Read<EnemyComponent, TransformComponent, CollisionComponent, BuildingComponent>()
+            .WriteResource<SpatialHashSystem>();
+    }
+
+private:
+    SpatialHash m_Enemies{ 2.0f };
+    SpatialHash m_Buildings{ 2.0f };
+    float m_MaxEnemyRadius = 0.0f;
+};
@@ -6,6 +6,7 @@
 #include "Components.h" 
 #include "imgui.h"
 #include <string>
+#include <algorithm>
 #include <GLFW/glfw3.h> 
 
 #include "RenderSystem.h"
@@ -13,6 +14,9 @@
 #include "Game.h"
 #include "ResourceSystem.h"
 #include "BalanceSystem.h"
+#include "Scheduler.h"
+#include "EnemyAISystem.h"
+#include "Constants.h"
 
 
 
@@ -98,14 +102,17 @@ public:
 
 private:
     UIState m_State;
+    std::vector<std::pair<size_t, double>> m_JobScaling; //threads, ms per tick
+    int m_MapSize[2] = { 20, 20 };
+    std::vector<PathfindingBenchmarkResult> m_PathBenchmark;
+    std::vector<EcsBenchmarkResult> m_EcsBenchmark;
+    LoadBenchmarkResult m_LoadBenchmark;
 
 
     void DrawMainHUD(ecs::Registry* registry) {
         ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
         ImGui::SetNextWindowSize(ImVec2(300, 150), ImGuiCond_Always);
 
-        auto balanceSystem = m_Registry->GetSystem<BalanceSystem>();
-
         if (ImGui::Begin("Game HUD", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove)) {
             ImGui::Text("Resources: %d", (int)m_State.resources);
             ImGui::Text("Unit Count: %d", (int)m_State.unitCount);
@@ -127,6 +134,8 @@ private:
         if (ImGui::Begin("Debug Info")) {
             ImGui::Text("Entities (UI System): %zu", m_Entities.size());
             ImGui::Text("Living Entities (Total): %d", registry->GetLivingEntityCount());
+            ImGui::Text("ECS Memory: %.1f KB components, %.1f KB entities",
+                registry->GetComponentMemoryUsage() / 1024.0, registry->GetEntityMemoryUsage() / 1024.0);
 
             Game* game = static_cast<Game*>(glfwGetWindowUserPointer(m_Registry->GetSystem<InputSystem>()->m_Window));
             if (game) {
@@ -136,9 +145,23 @@ private:
 
                 ImGui::Separator();
                 if (ImGui::Button("Spawn Enemy")) {
-                    game->SpawnEnemyAt({ 9.5f, 0.5f, 9.5f });
+                    game->SpawnEnemyAt(game->GetEnemySpawnPoint());
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Spawns 1 enemy in the far corner of the map");
+                ImGui::SameLine();
+                if (ImGui::Button("Spawn Wave")) {
+                    game->SpawnEnemiesAt(game->GetEnemySpawnPoint(), 100);
                 }
-                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Spawns 1 enemy at (10, 10)");
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Spawns 100 enemies in the far corner of the map in one batch");
+
+                ImGui::Separator();
+                ImGui::Text("Map: %d x %d", game->GetMapWidth(), game->GetMapHeight());
+                ImGui::InputInt2("##MapSize", m_MapSize);
+                ImGui::SameLine();
+                if (ImGui::Button("Resize Map")) {
+                    game->ResizeMap(std::max(1, std::min(m_MapSize[0], 1024)), std::max(1, std::min(m_MapSize[1], 1024)));
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Clears the world and rebuilds it on a map of this size (up to 1024 x 1024)");
             }
 
             if (ImGui::CollapsingHeader("Systems")) {
@@ -148,6 +171,122 @@ private:
 
             }
 
+            if (ImGui::CollapsingHeader("Pathing")) {
+                auto enemyAI = m_Registry->GetSystem<EnemyAISystem>();
+                int mode = static_cast<int>(enemyAI->GetPathingMode());
+                if (ImGui::RadioButton("Flow field", &mode, static_cast<int>(PathingMode::FlowField))) enemyAI->SetPathingMode(PathingMode::FlowField);
+                ImGui::SameLine();
+                if (ImGui::RadioButton("A* per enemy", &mode, static_cast<int>(PathingMode::AStar))) enemyAI->SetPathingMode(PathingMode::AStar);
+                ImGui::SameLine();
+                if (ImGui::RadioButton("HPA*", &mode, static_cast<int>(PathingMode::Hierarchical))) enemyAI->SetPathingMode(PathingMode::Hierarchical);
+                bool smooth = enemyAI->GetSmoothPaths();
+                if (ImGui::Checkbox("Smooth A*/HPA* paths", &smooth)) enemyAI->SetSmoothPaths(smooth);
+                int buckets = enemyAI->GetAiBuckets();
+                if (ImGui::SliderInt("AI buckets", &buckets, 1, 200)) enemyAI->SetAiBuckets(buckets);
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Idle enemies are split into this many groups that look for targets in turn over each second. 1 = everyone in the same tick");
+                ImGui::Text("AI tick: %.3f ms, peak %.3f ms over the last %d ticks, %zu targets acquired last tick",
+                    enemyAI->GetLastUpdateMs(), enemyAI->GetPeakUpdateMs(), EnemyAISystem::UPDATE_HISTORY, enemyAI->GetLastAcquisitions());
+                ImGui::PlotLines("##aicost", enemyAI->GetUpdateHistory(), EnemyAISystem::UPDATE_HISTORY, enemyAI->GetUpdateHistoryOffset(),
+                    nullptr, 0.0f, FLT_MAX, ImVec2(0, 40));
+                auto const& buildings = enemyAI->GetBuildingIndex();
+                ImGui::Text("Target index: %zu buildings, %zu tree rebuilds, %.1f KB", buildings.Size(), buildings.GetRebuilds(), buildings.GetMemoryUsage() / 1024.0);
+                ImGui::Text("Field rebuilds: %zu, last %.3f ms", enemyAI->GetFlowFieldBuilds(), enemyAI->GetLastFlowFieldBuildMs());
+                ImGui::Text("Field memory: %.1f KB", enemyAI->GetFlowField().GetMemoryUsage() / 1024.0);
+                auto const& hierarchy = enemyAI->GetHierarchy();
+                ImGui::Text("HPA*: %zu clusters, %zu entrance nodes, %.1f KB", hierarchy.GetClusterCount(), hierarchy.GetNodeCount(), hierarchy.GetMemoryUsage() / 1024.0);
+                ImGui::Text("HPA* last update: %zu clusters in %.3f ms", hierarchy.GetLastUpdateClusters(), enemyAI->GetLastHierarchyUpdateMs());
+
+                auto& requests = enemyAI->GetPathRequests();
+                float budget = (float)requests.GetBudgetMs();
+                if (ImGui::SliderFloat("Path budget (ms/tick)", &budget, 0.1f, 10.0f)) requests.SetBudgetMs(budget);
+                bool useWorkers = requests.GetUseWorkers();
+                if (ImGui::Checkbox("Solve A* requests on workers", &useWorkers)) requests.SetUseWorkers(useWorkers);
+                ImGui::Text("Requests: %zu pending, %zu solved and %zu dropped last tick in %.3f ms, %zu coalesced",
+                    requests.GetPendingCount(), requests.GetLastSolved(), requests.GetLastDropped(), requests.GetLastProcessMs(), requests.GetCoalescedCount());
+                auto& cache = enemyAI->GetPathCache();
+                size_t lookups = cache.GetHits() + cache.GetMisses();
+                ImGui::Text("Path cache: %zu hits, %zu misses (%.0f%%), %zu/%zu entries, flushed %zu times",
+                    cache.GetHits(), cache.GetMisses(), lookups ? 100.0 * cache.GetHits() / lookups : 0.0,
+                    cache.GetSize(), cache.GetCapacity(), cache.GetInvalidations());
+                auto const& pool = enemyAI->GetPathPool();
+                ImGui::Text("Path pool: %zu live paths, %zu tiles, %.1f KB, %zu stored, %zu collections (last %.3f ms)",
+                    pool.GetLivePaths(), pool.GetArenaTiles(), pool.GetMemoryUsage() / 1024.0, pool.GetStoredPaths(),
+                    pool.GetCollections(), pool.GetLastCollectMs());
+                ImGui::Text("Repairs: %zu spliced, %zu repathed, last batch %.3f ms, %zu indexed path tiles",
+                    enemyAI->GetPathRepairs(), enemyAI->GetPathRepairFallbacks(), enemyAI->GetLastRepairMs(), enemyAI->GetPathIndexEntries());
+
+                if (game && ImGui::Button("Run A* Maze Benchmark")) {
+                    m_PathBenchmark = game->RunPathfindingBenchmark();
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Random queries on 20x20, 256x256 and 1024x1024 mazes, flat A* against HPA*");
+                for (auto const& run : m_PathBenchmark) {
+                    ImGui::Text("%4d^2 A*:   %8.3f ms/query, %9.0f nodes, batch of %zu on all threads %.1f ms",
+                        run.mapSize, run.avgMs, run.avgNodes, run.queries, run.parallelMs);
+                    ImGui::Text("%4d^2 HPA*: %8.3f ms/query, %9.0f nodes, graph built in %.1f ms, x%.1f",
+                        run.mapSize, run.hpaMs, run.hpaNodes, run.hpaBuildMs, run.avgMs / run.hpaMs);
+                    ImGui::Text("%4d^2 smoothing: %.1f -> %.1f waypoints per path in %.3f ms",
+                        run.mapSize, run.avgWaypoints, run.avgSmoothed, run.smoothMs);
+                    ImGui::Text("%4d^2 walked: %.1f -> %.1f units per path, %zu movers %.3f -> %.3f ms/tick",
+                        run.mapSize, run.rawLength, run.smoothedLength, Game::MAZE_MOVERS, run.moveRawMs, run.moveSmoothedMs);
+                }
+            }
+
+            if (game && ImGui::CollapsingHeader("ECS Benchmark")) {
+                if (ImGui::Button("Run ECS Benchmark")) {
+                    m_EcsBenchmark = game->RunEcsBenchmark();
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Component pool and registry operations on throwaway registries");
+                for (auto const& run : m_EcsBenchmark) {
+                    ImGui::Text("%-32s %7zu %9.3f ms", run.name.c_str(), run.count, run.ms);
+                }
+            }
+
+            if (game && game->GetScheduler() && ImGui::CollapsingHeader("Schedule")) {
+                ecs::Scheduler* scheduler = game->GetScheduler();
+                bool parallel = scheduler->IsParallel();
+                if (ImGui::Checkbox("Run in parallel", &parallel)) {
+                    scheduler->SetParallel(parallel);
+                }
+                ImGui::Text("Last tick: %.3f ms", scheduler->GetLastTickMs());
+
+                //one row per system, grouped by the stage it can start in
+                auto const& entries = scheduler->GetEntries();
+                for (auto const& entry : entries) {
+                    std::string waitsFor;
+                    for (size_t dependency : entry.dependencies) {
+                        if (!waitsFor.empty()) waitsFor += ", ";
+                        waitsFor += entries[dependency].name;
+                    }
+                    ImGui::Text("[%zu] %-16s %.3f ms", entry.stage, entry.name.c_str(), entry.lastMs);
+                    if (!waitsFor.empty() && ImGui::IsItemHovered()) ImGui::SetTooltip("Waits for: %s", waitsFor.c_str());
+                }
+
+                if (ImGui::Button("Run Combat Load (10k/2k/5k)")) {
+                    m_LoadBenchmark = game->RunCombatLoadBenchmark(10000, 2000, 5000, 100);
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Replaces the world with a 200x200 map of 10k enemies, 2k turrets and 5k bullets, then runs 100 ticks");
+                if (m_LoadBenchmark.ticks > 0) {
+                    ImGui::Text("%zu enemies, %zu turrets, %zu bullets: %.3f ms/tick avg, %.3f max (step is %.0f ms)",
+                        m_LoadBenchmark.enemies, m_LoadBenchmark.turrets, m_LoadBenchmark.projectiles,
+                        m_LoadBenchmark.avgTickMs, m_LoadBenchmark.maxTickMs, fixedTimeStep * 1000.0);
+                    for (auto const& [name, ms] : m_LoadBenchmark.systemMs) {
+                        ImGui::Text("    %-16s %.3f ms", name.c_str(), ms);
+                    }
+                }
+            }
+
+            if (game && game->GetJobSystem() && ImGui::CollapsingHeader("Job System")) {
+                ImGui::Text("Workers: %zu (+ main thread)", game->GetJobSystem()->GetWorkerCount());
+                if (ImGui::Button("Run Scaling Benchmark")) {
+                    m_JobScaling = game->RunJobScalingBenchmark(100000, 20);
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("MovementSystem over 100k movers, 1..N threads");
+
+                for (auto const& [threads, ms] : m_JobScaling) {
+                    ImGui::Text("%2zu threads: %7.3f ms/tick  x%.2f", threads, ms, m_JobScaling.front().second / ms);
+                }
+            }
+
         }
         ImGui::End();
 
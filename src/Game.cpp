@@ -12,7 +12,15 @@
 #include "BalanceSystem.h"
 #include "ProjectileSystem.h"
 #include "CollisionSystem.h"
+#include "SpatialHashSystem.h"
 #include "Serializer.h"
+#include "Prefabs.h"
+#include "Scheduler.h"
+#include "JobSystem.h"
+#include "Constants.h"
+#include "Pathfinder.h"
+#include "HierarchicalPathfinder.h"
+#include <random>
 
 #include <stb/stb_image.h>
 
@@ -166,7 +174,7 @@ void Game::key_callback(GLFWwindow* window, int key, int scancode, int action, i
 
 
 Game::Game(int width, int height, const std::string& title)
-    : m_Window(nullptr), m_Width(width), m_Height(height), m_Title(title),
+    : m_Window(nullptr), m_Width(width), m_Height(height), m_MapWidth(defaultMapWidth), m_MapHeight(defaultMapHeight), m_Title(title),
     m_OrbitCamera(glm::vec3(0.0f)),
     m_FlyCamera(glm::vec3(0.0f, 15.0f, 15.0f)),
     m_CurrentState(AppState::MAIN_MENU),
@@ -215,32 +223,20 @@ void Game::OnBasePlaced(glm::vec3 position) {
 }
 
 void Game::SpawnEnemyAt(glm::vec3 position) {
+    SpawnEnemiesAt(position, 1);
+}
+
+void Game::SpawnEnemiesAt(glm::vec3 position, size_t count) {
     if (!m_BasePlaced) {
         std::cout << "Cannot spawn enemy: Base not placed." << std::endl;
         return;
     }
 
-    std::cout << "Spawning enemy at: " << position.x << "," << position.y << "," << position.z << std::endl;
-
-    auto enemy = m_Registry->CreateEntity();
-    m_Registry->AddComponent(enemy, TransformComponent{
-        position,
-        glm::vec3{0.12f},
-        {0.0f, 0.0f, 0.0f}
-        });
-    m_Registry->AddComponent(enemy, RenderComponent{ {0.8f, 0.2f, 0.8f, 1.0f} });
-    m_Registry->AddComponent(enemy, MeshComponent{ MeshType::Cube });
-    m_Registry->AddComponent(enemy, HealthComponent{ 50, 50 });
-    m_Registry->AddComponent(enemy, EnemyComponent{});
-
-    m_Registry->AddComponent(enemy, CollisionComponent{ 0.4f });
+    std::cout << "Spawning " << count << " enemies at: " << position.x << "," << position.y << "," << position.z << std::endl;
 
-    MovementComponent move;
-    move.speed = 3.0f;
-    move.path = {};
-    move.currentPathIndex = 0;
-
-    m_Registry->AddComponent(enemy, move);
+    m_Registry->Spawn(Prefabs::Enemy(), count, [&](ecs::Entity enemy, size_t) {
+        m_Registry->GetComponent<TransformComponent>(enemy).position = position;
+    });
 }
 
 
@@ -329,6 +325,7 @@ void Game::Init() {
     m_CombatSystem = m_Registry->RegisterSystem<CombatSystem>();
     m_ProjectileSystem = m_Registry->RegisterSystem<ProjectileSystem>();
     m_CollisionSystem = m_Registry->RegisterSystem<CollisionSystem>();
+    m_SpatialHashSystem = m_Registry->RegisterSystem<SpatialHashSystem>();
 
     //set signatures
     ecs::Signature renderSig;
@@ -383,13 +380,18 @@ void Game::Init() {
     m_RenderSystem->Init();
     m_UISystem->Init(m_Registry.get());
     m_InputSystem->Init(m_Window, m_Registry.get(), this);
-    m_GridSystem->Init();
+    m_GridSystem->Init(m_MapWidth, m_MapHeight);
+    m_OrbitCamera.SetBounds({ m_MapWidth / 2.0f, m_MapHeight / 2.0f });
 
     m_BalanceSystem->Init();
     m_ResourceSystem->Init(m_BalanceSystem.get(), 1000.0);
-    m_EnemyAISystem->Init(m_GridSystem.get());
-    m_CombatSystem->Init(m_BalanceSystem.get(), m_ResourceSystem.get(), m_GridSystem.get());
-   // m_MovementSystem->Init(m_GridSystem.get());
+    m_Jobs = std::make_unique<JobSystem>();
+    m_EnemyAISystem->Init(m_GridSystem.get(), m_Jobs.get());
+    m_CombatSystem->Init(m_BalanceSystem.get(), m_ResourceSystem.get(), m_GridSystem.get(), m_Jobs.get(), m_SpatialHashSystem.get());
+    m_MovementSystem->Init(m_Jobs.get(), &m_EnemyAISystem->GetPathPool());
+    m_ProjectileSystem->Init(m_GridSystem.get(), m_Jobs.get(), m_SpatialHashSystem.get());
+    m_CollisionSystem->Init(m_SpatialHashSystem.get());
+    BuildSchedule();
 
 
 
@@ -402,7 +404,7 @@ void Game::Init() {
 
 
     auto grid = m_Registry->CreateEntity();
-    m_Registry->AddComponent(grid, TransformComponent{ {0,0,0}, {20,1,20} });
+    m_Registry->AddComponent(grid, TransformComponent{ {0,0,0}, {(float)m_MapWidth, 1, (float)m_MapHeight} });
     m_Registry->AddComponent(grid, RenderComponent{ {0.2f, 0.2f, 0.2f, 1.0f} });
     m_Registry->AddComponent(grid, MeshComponent{ MeshType::Quad });
 
@@ -452,7 +454,7 @@ void Game::ToggleGodMode()
 
 void Game::Run() {
     double t = 0.0;
-    const double dt = 0.01;
+    const double dt = fixedTimeStep;
     double currentTime = glfwGetTime();
     double accumulator = 0.0;
 
@@ -480,20 +482,12 @@ void Game::Run() {
 
         case AppState::PLAYING:
             while (accumulator >= dt) {
-                m_ResourceSystem->Update((float)dt);
                 m_UISystem->Update((float)dt);
                 if (!m_IsGodMode) {
                     m_InputSystem->Update();
                 }
-                if (m_BasePlaced) {
-                    auto& enemyEntities = m_EnemyAISystem->m_Entities;
-                    auto& renderableEntities = m_RenderSystem->m_Entities;
-                    m_EnemyAISystem->Update((float)dt, m_Registry.get(), renderableEntities);
-                    m_CombatSystem->Update((float)dt, m_Registry.get(), enemyEntities, renderableEntities);
-                    m_ProjectileSystem->Update((float)dt, m_Registry.get(), enemyEntities);
-                }
-                m_MovementSystem->Update((float)dt);
-                m_CollisionSystem->Update((float)dt, m_GridSystem.get());
+                m_Scheduler->Run();
+                PlaybackCommands();
 
                 accumulator -= dt;
                 t += dt;
@@ -512,6 +506,449 @@ void Game::Run() {
 
 
 
+//simulation systems in their serial order; the scheduler runs whatever does not conflict side by side
+void Game::BuildSchedule() {
+    m_Scheduler = std::make_unique<ecs::Scheduler>(m_Jobs.get());
+    const float dt = static_cast<float>(fixedTimeStep);
+
+    m_Scheduler->Add("SpatialHashSystem", m_SpatialHashSystem->GetAccess(), [this]() {
+        m_SpatialHashSystem->Update(m_Registry.get());
+    });
+    m_Scheduler->Add("ResourceSystem", m_ResourceSystem->GetAccess(), [this, dt]() {
+        m_ResourceSystem->Update(dt);
+    });
+    m_Scheduler->Add("EnemyAISystem", m_EnemyAISystem->GetAccess(), [this, dt]() {
+        if (m_BasePlaced) m_EnemyAISystem->Update(dt, m_Registry.get());
+    });
+    m_Scheduler->Add("CombatSystem", m_CombatSystem->GetAccess(), [this, dt]() {
+        if (m_BasePlaced) m_CombatSystem->Update(dt, m_Registry.get());
+    });
+    m_Scheduler->Add("ProjectileSystem", m_ProjectileSystem->GetAccess(), [this, dt]() {
+        if (m_BasePlaced) m_ProjectileSystem->Update(dt, m_Registry.get());
+    });
+    m_Scheduler->Add("MovementSystem", m_MovementSystem->GetAccess(), [this, dt]() {
+        m_MovementSystem->Update(dt);
+    });
+    m_Scheduler->Add("CollisionSystem", m_CollisionSystem->GetAccess(), [this, dt]() {
+        m_CollisionSystem->Update(dt, m_GridSystem.get());
+    });
+}
+
+//times MovementSystem over a throwaway registry of moving enemies with 1..N threads, returns (threads, ms per tick)
+std::vector<std::pair<size_t, double>> Game::RunJobScalingBenchmark(size_t entityCount, int ticks) {
+    ecs::Registry registry;
+    registry.RegisterComponent<TransformComponent>();
+    registry.RegisterComponent<MovementComponent>();
+    PathPool paths;
+    paths.Init(m_GridSystem.get());
+    PathHandle farTile = paths.Store(glm::ivec2(m_MapWidth - 1, m_MapHeight / 2)); //one shared path, nobody gets there during the run
+    auto movement = registry.RegisterSystem<MovementSystem>();
+    movement->Init(m_Jobs.get(), &paths);
+
+    ecs::Prefab mover;
+    mover.With(TransformComponent{}).With(MovementComponent{});
+    registry.Spawn(mover, entityCount, [&](ecs::Entity entity, size_t i) {
+        glm::vec3 start(-1000.0f - (float)(i % 1000), 0.5f, (float)(i / 1000));
+        registry.GetComponent<TransformComponent>(entity).position = start;
+        registry.GetComponent<MovementComponent>(entity).path = farTile;
+    });
+
+    std::vector<std::pair<size_t, double>> results;
+    size_t activeWorkers = m_Jobs->GetActiveWorkers();
+    for (size_t workers = 0; workers <= m_Jobs->GetWorkerCount(); ++workers) {
+        m_Jobs->SetActiveWorkers(workers);
+        movement->Update((float)fixedTimeStep); //warm up
+
+        double start = glfwGetTime();
+        for (int i = 0; i < ticks; ++i) {
+            movement->Update((float)fixedTimeStep);
+        }
+        results.push_back({ workers + 1, (glfwGetTime() - start) * 1000.0 / ticks });
+    }
+    m_Jobs->SetActiveWorkers(activeWorkers);
+    return results;
+}
+
+LoadBenchmarkResult Game::RunCombatLoadBenchmark(size_t enemies, size_t turrets, size_t projectiles, int ticks) {
+    const int mapSize = 200;
+    ResizeMap(mapSize, mapSize);
+    std::mt19937 rng(99);
+    auto randomFreeTile = [&]() {
+        glm::ivec2 tile;
+        do {
+            tile = { (int)(rng() % mapSize), (int)(rng() % mapSize) };
+        } while (!m_GridSystem->IsWalkable(tile.x, tile.y));
+        return tile;
+    };
+    auto placeBuilding = [&](const ecs::Prefab& prefab, glm::ivec2 tile, float yOffset) {
+        glm::vec3 position = m_GridSystem->GridToWorld(tile.x, tile.y) + glm::vec3(0.0f, yOffset, 0.0f);
+        ecs::Entity building = m_Registry->Spawn(prefab, 1, [&](ecs::Entity entity, size_t) {
+            m_Registry->GetComponent<TransformComponent>(entity).position = position;
+        })[0];
+        m_GridSystem->SetEntityAt(tile.x, tile.y, building);
+        return position;
+    };
+
+    OnBasePlaced(placeBuilding(Prefabs::Base(), { mapSize / 2, mapSize / 2 }, 0.0f));
+    for (size_t i = 0; i < turrets; ++i) {
+        placeBuilding(Prefabs::Turret(), randomFreeTile(), 0.0f);
+    }
+    m_Registry->Spawn(Prefabs::Enemy(), enemies, [&](ecs::Entity enemy, size_t) {
+        glm::ivec2 tile = randomFreeTile();
+        m_Registry->GetComponent<TransformComponent>(enemy).position = m_GridSystem->GridToWorld(tile.x, tile.y) + glm::vec3(0.0f, 0.5f, 0.0f);
+    });
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    m_Registry->Spawn(Prefabs::Projectile(), projectiles, [&](ecs::Entity bullet, size_t) {
+        glm::ivec2 tile = randomFreeTile();
+        float heading = angle(rng);
+        m_Registry->GetComponent<TransformComponent>(bullet).position = m_GridSystem->GridToWorld(tile.x, tile.y) + glm::vec3(0.0f, 0.5f, 0.0f);
+        m_Registry->GetComponent<ProjectileComponent>(bullet).velocity = glm::vec3(std::cos(heading), 0.0f, std::sin(heading)) * 15.0f;
+    });
+
+    LoadBenchmarkResult result;
+    result.enemies = enemies;
+    result.turrets = turrets;
+    result.projectiles = projectiles;
+    result.ticks = ticks;
+    auto const& entries = m_Scheduler->GetEntries();
+    for (auto const& entry : entries) result.systemMs.push_back({ entry.name, 0.0 });
+    for (int tick = 0; tick < ticks; ++tick) {
+        m_Scheduler->Run();
+        PlaybackCommands();
+        result.avgTickMs += m_Scheduler->GetLastTickMs();
+        result.maxTickMs = std::max(result.maxTickMs, m_Scheduler->GetLastTickMs());
+        for (size_t i = 0; i < entries.size(); ++i) result.systemMs[i].second += entries[i].lastMs;
+    }
+    result.avgTickMs /= ticks;
+    for (auto& system : result.systemMs) system.second /= ticks;
+    return result;
+}
+
+//perfect maze: passages on even tiles, carved with an iterative depth-first search so every tile pair has exactly
+//one route and A* has to explore the dead ends
+static void BuildMaze(GridSystem& grid, int size, uint32_t seed) {
+    grid.Init(size, size);
+    std::vector<bool> open(static_cast<size_t>(size) * size, false);
+    auto at = [&](int x, int y) { return open[static_cast<size_t>(y) * size + x]; };
+    auto carve = [&](int x, int y) { open[static_cast<size_t>(y) * size + x] = true; };
+
+    std::mt19937 rng(seed);
+    std::vector<glm::ivec2> stack = { {0, 0} };
+    carve(0, 0);
+    const glm::ivec2 steps[4] = { {2, 0}, {-2, 0}, {0, 2}, {0, -2} };
+    while (!stack.empty()) {
+        glm::ivec2 cell = stack.back();
+        glm::ivec2 options[4];
+        int optionCount = 0;
+        for (auto const& step : steps) {
+            glm::ivec2 next = cell + step;
+            if (next.x >= 0 && next.x < size && next.y >= 0 && next.y < size && !at(next.x, next.y)) {
+                options[optionCount++] = next;
+            }
+        }
+        if (optionCount == 0) {
+            stack.pop_back();
+            continue;
+        }
+        glm::ivec2 next = options[rng() % optionCount];
+        carve((cell.x + next.x) / 2, (cell.y + next.y) / 2);
+        carve(next.x, next.y);
+        stack.push_back(next);
+    }
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            if (!at(x, y)) grid.SetEntityAt(x, y, 0);
+        }
+    }
+}
+
+//distance walked from start through every waypoint, on the XZ plane
+static double PathLength(glm::vec3 start, const std::vector<glm::vec3>& path) {
+    double length = 0.0;
+    glm::vec2 previous = { start.x, start.z };
+    for (auto const& waypoint : path) {
+        glm::vec2 next = { waypoint.x, waypoint.z };
+        length += glm::distance(previous, next);
+        previous = next;
+    }
+    return length;
+}
+
+//MAZE_MOVERS enemies dealt round robin over the paths, each starting on its path's first tile. returns ms per
+//MovementSystem tick, averaged over 100 ticks
+static double TimeMazeMovers(JobSystem* jobs, const GridSystem& maze, const PathPool& paths,
+    const std::vector<std::pair<glm::ivec2, glm::ivec2>>& pairs, const std::vector<PathHandle>& handles) {
+    const int ticks = 100;
+    ecs::Registry registry;
+    registry.RegisterComponent<TransformComponent>();
+    registry.RegisterComponent<MovementComponent>();
+    auto movement = registry.RegisterSystem<MovementSystem>();
+    movement->Init(jobs, &paths);
+
+    ecs::Prefab mover;
+    mover.With(TransformComponent{}).With(MovementComponent{});
+    registry.Spawn(mover, Game::MAZE_MOVERS, [&](ecs::Entity entity, size_t i) {
+        glm::ivec2 start = pairs[i % pairs.size()].first;
+        registry.GetComponent<TransformComponent>(entity).position = maze.GridToWorld(start.x, start.y) + glm::vec3(0.0f, 0.5f, 0.0f);
+        registry.GetComponent<MovementComponent>(entity).path = handles[i % handles.size()];
+    });
+
+    double start = glfwGetTime();
+    for (int i = 0; i < ticks; ++i) {
+        movement->Update((float)fixedTimeStep);
+    }
+    return (glfwGetTime() - start) * 1000.0 / ticks;
+}
+
+std::vector<PathfindingBenchmarkResult> Game::RunPathfindingBenchmark() {
+    const std::pair<int, size_t> runs[] = { {20, 1000}, {256, 100}, {1024, 10} };
+    std::vector<PathfindingBenchmarkResult> results;
+
+    for (auto const& [size, queries] : runs) {
+        GridSystem maze;
+        BuildMaze(maze, size, 1234);
+
+        //random passage tile pairs, fixed seed so runs compare
+        std::mt19937 rng(42);
+        int cells = (size + 1) / 2;
+        std::vector<std::pair<glm::ivec2, glm::ivec2>> pairs(queries);
+        for (auto& pair : pairs) {
+            pair.first = { (int)(rng() % cells) * 2, (int)(rng() % cells) * 2 };
+            pair.second = { (int)(rng() % cells) * 2, (int)(rng() % cells) * 2 };
+        }
+
+        PathfindingBenchmarkResult result{ size, queries, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        PathPool paths;
+        paths.Init(&maze);
+        std::vector<PathHandle> rawPaths, smoothedPaths;
+        Pathfinder::PathfinderContext& context = Pathfinder::ThreadContext();
+        for (auto const& [from, to] : pairs) {
+            std::vector<glm::vec3> path = context.FindPath(&maze, from, to);
+            result.avgMs += context.GetLastStats().ms;
+            result.avgNodes += (double)context.GetLastStats().nodesExpanded;
+            result.avgWaypoints += (double)path.size();
+            result.rawLength += PathLength(maze.GridToWorld(from.x, from.y), path);
+            rawPaths.push_back(paths.Store(path));
+
+            double start = glfwGetTime();
+            Pathfinder::SmoothPath(&maze, path);
+            result.smoothMs += (glfwGetTime() - start) * 1000.0;
+            result.avgSmoothed += (double)path.size();
+            result.smoothedLength += PathLength(maze.GridToWorld(from.x, from.y), path);
+            smoothedPaths.push_back(paths.Store(path));
+        }
+        result.avgMs /= (double)queries;
+        result.avgNodes /= (double)queries;
+        result.avgWaypoints /= (double)queries;
+        result.avgSmoothed /= (double)queries;
+        result.smoothMs /= (double)queries;
+        result.rawLength /= (double)queries;
+        result.smoothedLength /= (double)queries;
+        result.moveRawMs = TimeMazeMovers(m_Jobs.get(), maze, paths, pairs, rawPaths);
+        result.moveSmoothedMs = TimeMazeMovers(m_Jobs.get(), maze, paths, pairs, smoothedPaths);
+
+        double start = glfwGetTime();
+        m_Jobs->ParallelFor(pairs.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Pathfinder::FindPath(&maze, pairs[i].first, pairs[i].second);
+            }
+        }, 1);
+        result.parallelMs = (glfwGetTime() - start) * 1000.0;
+
+        HierarchicalPathfinder hierarchy;
+        start = glfwGetTime();
+        hierarchy.Build(maze);
+        result.hpaBuildMs = (glfwGetTime() - start) * 1000.0;
+
+        start = glfwGetTime();
+        for (auto const& [from, to] : pairs) {
+            std::vector<glm::ivec2> legs = hierarchy.FindAbstractPath(maze, from, to);
+            result.hpaNodes += (double)hierarchy.GetLastStats().nodesExpanded;
+            for (size_t i = 1; i < legs.size(); ++i) {
+                hierarchy.RefineSegment(maze, legs[i - 1], legs[i]);
+            }
+        }
+        result.hpaMs = (glfwGetTime() - start) * 1000.0 / (double)queries;
+        result.hpaNodes /= (double)queries;
+
+        results.push_back(result);
+    }
+    return results;
+}
+
+//component pool on count shuffled ids: insert them all, look each one up `passes` times, test as often over twice as
+//many ids (so half of them miss), then remove them all
+static void BenchmarkComponentPool(size_t count, int passes, std::vector<EcsBenchmarkResult>& results) {
+    std::string times = " (x" + std::to_string(passes) + ")";
+    std::vector<ecs::Entity> ids(2 * count);
+    for (size_t i = 0; i < ids.size(); ++i) ids[i] = ecs::MakeEntity(static_cast<uint32_t>(i), 0);
+    std::mt19937 rng(7);
+    std::shuffle(ids.begin(), ids.begin() + count, rng);
+
+    ecs::ComponentArray<TransformComponent> pool;
+    double start = glfwGetTime();
+    for (size_t i = 0; i < count; ++i) pool.InsertData(ids[i], TransformComponent{});
+    results.push_back({ "pool insert", count, (glfwGetTime() - start) * 1000.0 });
+
+    float sum = 0.0f;
+    start = glfwGetTime();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (size_t i = 0; i < count; ++i) sum += pool.GetData(ids[i]).position.x;
+    }
+    results.push_back({ "pool get" + times, count, (glfwGetTime() - start) * 1000.0 });
+
+    size_t hits = 0;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    start = glfwGetTime();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (ecs::Entity id : ids) hits += pool.HasData(id);
+    }
+    results.push_back({ "pool has, half miss" + times, ids.size(), (glfwGetTime() - start) * 1000.0 });
+
+    start = glfwGetTime();
+    for (ecs::Entity id : ids) {
+        if (pool.HasData(id)) pool.RemoveData(id);
+    }
+    results.push_back({ "pool remove", count, (glfwGetTime() - start) * 1000.0 });
+
+    if (sum != 0.0f || hits != static_cast<size_t>(passes) * count) std::cout << "ECS benchmark: unexpected pool state" << std::endl;
+}
+
+//moving a sparse subset of the world one step per tick: walking a system's entity set and fetching every component
+//by entity, against a view that walks the smaller pool and resolves the other through its sparse index
+static void BenchmarkViews(std::vector<EcsBenchmarkResult>& results) {
+    const size_t entityCount = 4990;
+    const int ticks = 1000;
+    const float dt = static_cast<float>(fixedTimeStep);
+    ecs::Registry registry;
+    registry.RegisterComponent<TransformComponent>();
+    registry.RegisterComponent<MovementComponent>();
+    auto movers = registry.RegisterSystem<MovementSystem>();
+    ecs::Signature signature;
+    signature.set(registry.GetComponentTypeID<TransformComponent>());
+    signature.set(registry.GetComponentTypeID<MovementComponent>());
+    registry.SetSystemSignature<MovementSystem>(signature);
+
+    for (size_t i = 0; i < entityCount; ++i) {
+        ecs::Entity entity = registry.CreateEntity();
+        registry.AddComponent(entity, TransformComponent{});
+        if (i % 4 == 0) registry.AddComponent(entity, MovementComponent{});
+    }
+
+    double start = glfwGetTime();
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (ecs::Entity entity : movers->m_Entities) {
+            registry.GetComponent<TransformComponent>(entity).position.x += registry.GetComponent<MovementComponent>(entity).speed * dt;
+        }
+    }
+    results.push_back({ "move: set + GetComponent (x1000)", movers->m_Entities.size(), (glfwGetTime() - start) * 1000.0 });
+
+    start = glfwGetTime();
+    for (int tick = 0; tick < ticks; ++tick) {
+        registry.View<TransformComponent, MovementComponent>().Each([dt](ecs::Entity, TransformComponent& transform, MovementComponent& movement) {
+            transform.position.x += movement.speed * dt;
+        });
+    }
+    results.push_back({ "move: View::Each (x1000)", movers->m_Entities.size(), (glfwGetTime() - start) * 1000.0 });
+}
+
+//save loading: restoring saved handles (holes between them, mixed generations, file order) one at a time, against
+//sorting them and reserving them in one CreateEntities call the way LoadGame does. the sort is part of the timing
+static void BenchmarkLoadIds(std::vector<EcsBenchmarkResult>& results) {
+    const uint32_t slotCount = 150000;
+    std::mt19937 rng(11);
+    std::vector<ecs::Entity> savedIds;
+    for (uint32_t index = 0; index < slotCount; ++index) {
+        if (rng() % 5 == 0) continue; //destroyed before saving
+        savedIds.push_back(ecs::MakeEntity(index, rng() % 16));
+    }
+    std::shuffle(savedIds.begin(), savedIds.end(), rng);
+
+    ecs::Registry perId;
+    double start = glfwGetTime();
+    for (ecs::Entity id : savedIds) perId.CreateEntity(id);
+    results.push_back({ "load: CreateEntity(id) each", savedIds.size(), (glfwGetTime() - start) * 1000.0 });
+
+    ecs::Registry bulk;
+    start = glfwGetTime();
+    std::vector<ecs::Entity> sorted = savedIds;
+    std::sort(sorted.begin(), sorted.end(), [](ecs::Entity a, ecs::Entity b) {
+        return ecs::GetEntityIndex(a) < ecs::GetEntityIndex(b);
+    });
+    bulk.CreateEntities(sorted);
+    results.push_back({ "load: sorted CreateEntities", savedIds.size(), (glfwGetTime() - start) * 1000.0 });
+}
+
+//a wave of enemies built component by component, against one prefab Spawn. both registries know the game's
+//components and the two simulation systems an enemy joins through its own components, so system matching is timed too
+static void BenchmarkSpawn(std::vector<EcsBenchmarkResult>& results) {
+    const size_t count = 10000;
+    auto makeRegistry = []() {
+        auto registry = std::make_unique<ecs::Registry>();
+        registry->RegisterComponent<TransformComponent>();
+        registry->RegisterComponent<RenderComponent>();
+        registry->RegisterComponent<MeshComponent>();
+        registry->RegisterComponent<HealthComponent>();
+        registry->RegisterComponent<MovementComponent>();
+        registry->RegisterComponent<EnemyComponent>();
+        registry->RegisterComponent<CollisionComponent>();
+        registry->RegisterSystem<MovementSystem>();
+        registry->RegisterSystem<CollisionSystem>();
+        ecs::Signature moveSig;
+        moveSig.set(registry->GetComponentTypeID<TransformComponent>());
+        moveSig.set(registry->GetComponentTypeID<MovementComponent>());
+        registry->SetSystemSignature<MovementSystem>(moveSig);
+        ecs::Signature collisionSig;
+        collisionSig.set(registry->GetComponentTypeID<TransformComponent>());
+        collisionSig.set(registry->GetComponentTypeID<CollisionComponent>());
+        registry->SetSystemSignature<CollisionSystem>(collisionSig);
+        return registry;
+    };
+
+    auto oneByOne = makeRegistry();
+    double start = glfwGetTime();
+    for (size_t i = 0; i < count; ++i) {
+        ecs::Entity enemy = oneByOne->CreateEntity();
+        oneByOne->AddComponent(enemy, TransformComponent{ {0.0f, 0.0f, 0.0f}, glm::vec3{0.12f}, {0.0f, 0.0f, 0.0f} });
+        oneByOne->AddComponent(enemy, RenderComponent{ {0.8f, 0.2f, 0.8f, 1.0f} });
+        oneByOne->AddComponent(enemy, MeshComponent{ MeshType::Cube });
+        oneByOne->AddComponent(enemy, HealthComponent{ 50, 50 });
+        oneByOne->AddComponent(enemy, EnemyComponent{});
+        oneByOne->AddComponent(enemy, CollisionComponent{ 0.4f });
+        oneByOne->AddComponent(enemy, MovementComponent{});
+    }
+    results.push_back({ "spawn: 7x AddComponent each", count, (glfwGetTime() - start) * 1000.0 });
+    oneByOne.reset(); //hand its pages back so the batch doesn't pay for fresh memory the first run didn't
+
+    auto batched = makeRegistry();
+    start = glfwGetTime();
+    batched->Spawn(Prefabs::Enemy(), count);
+    results.push_back({ "spawn: Registry::Spawn batch", count, (glfwGetTime() - start) * 1000.0 });
+}
+
+//the registry operations the ECS rework was about, each on a throwaway registry so the world is left alone
+std::vector<EcsBenchmarkResult> Game::RunEcsBenchmark() {
+    std::vector<EcsBenchmarkResult> results;
+    //the big pools get fewer lookup passes so the button doesn't freeze the game for long
+    BenchmarkComponentPool(5000, 100, results);
+    BenchmarkComponentPool(50000, 10, results);
+    BenchmarkComponentPool(500000, 10, results);
+    BenchmarkViews(results);
+    BenchmarkLoadIds(results);
+    BenchmarkSpawn(results);
+    return results;
+}
+
+//sync point: structural changes recorded by the simulation systems are applied here, always in the same system order
+void Game::PlaybackCommands() {
+    m_EnemyAISystem->m_Commands.Playback(*m_Registry);
+    m_CombatSystem->m_Commands.Playback(*m_Registry);
+    m_ProjectileSystem->m_Commands.Playback(*m_Registry);
+    m_MovementSystem->m_Commands.Playback(*m_Registry);
+    m_CollisionSystem->m_Commands.Playback(*m_Registry);
+}
+
 void Game::ProcessInput(float dt)
 {
     glfwPollEvents();
@@ -583,17 +1020,18 @@ void Game::Cleanup() {
 void Game::ClearWorld()
 {
     m_Registry->Reset();
-    m_GridSystem->Init();
+    m_GridSystem->Init(m_MapWidth, m_MapHeight);
+    m_OrbitCamera.SetBounds({ m_MapWidth / 2.0f, m_MapHeight / 2.0f });
     m_BalanceSystem->Init();
     m_ResourceSystem->Init(m_BalanceSystem.get(), 1000);
-    m_EnemyAISystem->Init(m_GridSystem.get());
-    m_CombatSystem->Init(m_BalanceSystem.get(), m_ResourceSystem.get(), m_GridSystem.get());
+    m_EnemyAISystem->Init(m_GridSystem.get(), m_Jobs.get());
+    m_CombatSystem->Init(m_BalanceSystem.get(), m_ResourceSystem.get(), m_GridSystem.get(), m_Jobs.get(), m_SpatialHashSystem.get());
 
     m_BasePlaced = false;
     m_BasePosition = { 0,0,0 };
 
     auto grid = m_Registry->CreateEntity();
-    m_Registry->AddComponent(grid, TransformComponent{ {0,0,0}, {20,1,20} });
+    m_Registry->AddComponent(grid, TransformComponent{ {0,0,0}, {(float)m_MapWidth, 1, (float)m_MapHeight} });
     m_Registry->AddComponent(grid, RenderComponent{ {0.2f, 0.2f, 0.2f, 1.0f} });
     m_Registry->AddComponent(grid, MeshComponent{ MeshType::Quad });
 
@@ -604,12 +1042,27 @@ void Game::ClearWorld()
     m_Registry->AddComponent(highlighter, GhostComponent{});
 }
 
+void Game::ResizeMap(int width, int height)
+{
+    m_MapWidth = width;
+    m_MapHeight = height;
+    ClearWorld();
+}
+
+glm::vec3 Game::GetEnemySpawnPoint() const
+{
+    glm::vec3 corner = m_GridSystem->GridToWorld(m_MapWidth - 1, m_MapHeight - 1);
+    return { corner.x, 0.5f, corner.z };
+}
+
 
 void Game::SaveGame()
 {
     std::cout << "Saving game..." << std::endl;
     json saveFile;
 
+    saveFile["globals"]["map_width"] = m_MapWidth;
+    saveFile["globals"]["map_height"] = m_MapHeight;
     saveFile["globals"]["base_placed"] = m_BasePlaced;
     saveFile["globals"]["base_pos"] = m_BasePosition;
     saveFile["globals"]["resources"] = m_ResourceSystem->GetResources();
@@ -620,7 +1073,7 @@ void Game::SaveGame()
     saveFile["entities"] = json::array();
     for (const auto& entity : m_Registry->GetLivingEntities())
     {
-        if (entity == 0 || entity == 1) continue;
+        if (ecs::GetEntityIndex(entity) < 2) continue; //grid and highlighter are rebuilt by ClearWorld
 
         json entityJson;
         entityJson["id"] = entity;
@@ -660,6 +1113,7 @@ void Game::SaveGame()
 void Game::LoadGame()
 {
     std::cout << "Loading game..." << std::endl;
+    double loadStart = glfwGetTime();
     json saveFile;
     std::ifstream i("savegame.json");
     if (!i.is_open()) {
@@ -677,6 +1131,13 @@ void Game::LoadGame()
     }
     i.close();
 
+    //saves from before maps were resizable don't have these
+    m_MapWidth = defaultMapWidth;
+    m_MapHeight = defaultMapHeight;
+    if (saveFile["globals"].contains("map_width"))
+        m_MapWidth = saveFile["globals"]["map_width"].get<int>();
+    if (saveFile["globals"].contains("map_height"))
+        m_MapHeight = saveFile["globals"]["map_height"].get<int>();
     ClearWorld();
 
     m_BasePlaced = saveFile["globals"]["base_placed"].get<bool>();
@@ -686,10 +1147,19 @@ void Game::LoadGame()
     m_OrbitCamera.SetTarget(saveFile["globals"]["cam_target"].get<glm::vec3>());
     m_OrbitCamera.SetDistance(saveFile["globals"]["cam_dist"].get<float>());
 
+    //reserve every saved id in one sorted pass before filling in components
+    std::vector<ecs::Entity> savedIds;
+    for (const auto& entityJson : saveFile["entities"]) {
+        savedIds.push_back(entityJson["id"].get<ecs::Entity>());
+    }
+    std::sort(savedIds.begin(), savedIds.end(), [](ecs::Entity a, ecs::Entity b) {
+        return ecs::GetEntityIndex(a) < ecs::GetEntityIndex(b);
+    });
+    m_Registry->CreateEntities(savedIds);
+
     for (const auto& entityJson : saveFile["entities"])
     {
-        ecs::Entity id = entityJson["id"].get<ecs::Entity>();
-        auto entity = m_Registry->CreateEntity(id);
+        auto entity = entityJson["id"].get<ecs::Entity>();
 
         if (entityJson.contains("transform"))
             m_Registry->AddComponent(entity, entityJson.at("transform").get<TransformComponent>());
@@ -730,6 +1200,6 @@ void Game::LoadGame()
         }
     }
 
-    std::cout << "Game loaded!" << std::endl;
+    std::cout << "Game loaded! (" << savedIds.size() << " entities in " << (glfwGetTime() - loadStart) * 1000.0 << " ms)" << std::endl;
     SetAppState(AppState::PLAYING);
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <algorithm> 
 #include "Constants.h"
+#include "Prefabs.h"
 
 void InputSystem::SetWindowSize(int width, int height) {
     m_Width = width;
@@ -93,7 +94,8 @@ void InputSystem::RotateBuildFootprint(int direction) {
 }
 
 std::optional<ecs::Entity> InputSystem::GetHighlighter() {
-    for (auto const& entity : m_Entities) {
+    auto ghosts = m_Registry->View<GhostComponent, TransformComponent, RenderComponent, MeshComponent>();
+    for (auto const& entity : ghosts) {
         return entity;
     }
     return std::nullopt;
@@ -203,45 +205,25 @@ void InputSystem::HandleMouseClick() {
                 glm::ivec2 anchorGridPos = gridSystem->WorldToGrid(h_transform.position -
                     glm::vec3((m_BuildFootprint.x / 2.0f) - 0.5f, 0.0f, (m_BuildFootprint.y / 2.0f) - 0.5f));
 
-                auto building = m_Registry->CreateEntity();
-
                 float yOffset = 0.0f;
                 if (m_BuildMeshType == MeshType::Cube || m_BuildMeshType == MeshType::Sphere) {
                     yOffset = 0.5f;
                 }
                 glm::vec3 buildPos = { h_transform.position.x, yOffset, h_transform.position.z };
 
-                m_Registry->AddComponent(building, TransformComponent{
-                    buildPos,
-                    h_transform.scale,
-                    h_transform.rotation //0 90 180 270 loop
-                    });
-
-                glm::vec4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
-                if (m_BuildBuildingType == BuildingType::ResourceNode) {
-                    color = { 0.2f, 0.8f, 0.2f, 1.0f };
-                }
-                m_Registry->AddComponent(building, RenderComponent{ color });
-                m_Registry->AddComponent(building, MeshComponent{ m_BuildMeshType });
-                m_Registry->AddComponent(building, BuildingComponent{ m_BuildBuildingType });
-                m_Registry->AddComponent(building, CollisionComponent{ 0.5f });
-
+                const ecs::Prefab* prefab = Prefabs::ForBuilding(m_BuildBuildingType);
+                assert(prefab && "No prefab for building type");
+                auto building = m_Registry->Spawn(*prefab, 1, [&](ecs::Entity entity, size_t) {
+                    m_Registry->GetComponent<TransformComponent>(entity) = TransformComponent{
+                        buildPos,
+                        h_transform.scale,
+                        h_transform.rotation //0 90 180 270 loop
+                    };
+                    m_Registry->GetComponent<MeshComponent>(entity).type = m_BuildMeshType;
+                })[0];
 
                 if (m_BuildBuildingType == BuildingType::Base) {
                     m_Game->OnBasePlaced(buildPos);
-                    m_Registry->AddComponent(building, HealthComponent{ 500, 500 });
-                }
-                else if (m_BuildBuildingType == BuildingType::ResourceNode) {
-                    m_Registry->AddComponent(building, ResourceGeneratorComponent{});
-                    m_Registry->AddComponent(building, HealthComponent{ 50, 50 });
-                }
-                else if (m_BuildBuildingType == BuildingType::Turret) {
-                    m_Registry->AddComponent(building, TurretAIComponent{});
-                    m_Registry->AddComponent(building, HealthComponent{ 100, 100 });
-                }
-                else if (m_BuildBuildingType == BuildingType::Bomb) {
-                    m_Registry->AddComponent(building, BombComponent{});
-                    m_Registry->AddComponent(building, HealthComponent{ 1, 1 });
                 }
 
 
@@ -0,0 +1,94 @@
+//standalone checks for PathRequestService, not part of the game project. build and run from the repo root with
+//  g++ -std=c++17 -Iheaders -ILibraries/include tests/PathRequestServiceTest.cpp -o PathRequestServiceTest -pthread
+#include "PathRequestService.h"
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+//one search per Process call (budget 0, serial solver), so whatever gets solved is what the budget was spent on
+static void DroppedRequestsDoNotSpendTheBudget() {
+    PathRequestService requests;
+    requests.Init(nullptr);
+    requests.SetBudgetMs(0.0);
+
+    const ecs::Entity cancelled = 1, replaced = 2, live = 3;
+    requests.Submit(cancelled, { 0, 0 }, { 5, 5 }, 100);
+    requests.Submit(replaced, { 1, 1 }, { 6, 6 }, 50);
+    requests.Submit(live, { 2, 2 }, { 7, 7 }, 0);
+    requests.Cancel(cancelled);
+    requests.Submit(replaced, { 1, 1 }, { 8, 8 }, 10); //the { 6, 6 } search now has nobody waiting for it
+
+    std::vector<glm::ivec2> solvedGoals;
+    std::vector<ecs::Entity> delivered;
+    auto solve = [&](glm::ivec2, glm::ivec2 goal, PathResult&) {
+        solvedGoals.push_back(goal);
+    };
+    auto store = [](glm::ivec2, glm::ivec2, const std::shared_ptr<const PathResult>&) {};
+    auto deliver = [&](ecs::Entity entity, const PathResult&) { delivered.push_back(entity); };
+
+    requests.Process(solve, false, store, deliver);
+    assert(requests.GetLastDropped() == 2);
+    assert(solvedGoals.size() == 1 && solvedGoals[0] == glm::ivec2(8, 8)); //highest priority live request
+    assert(delivered.size() == 1 && delivered[0] == replaced);
+    assert(requests.GetPendingCount() == 1);
+
+    requests.Process(solve, false, store, deliver);
+    assert(requests.GetLastDropped() == 0);
+    assert(solvedGoals.size() == 2 && solvedGoals[1] == glm::ivec2(7, 7));
+    assert(delivered.size() == 2 && delivered[1] == live);
+    assert(requests.GetPendingCount() == 0);
+    for (glm::ivec2 goal : solvedGoals) assert(goal != glm::ivec2(5, 5) && goal != glm::ivec2(6, 6));
+}
+
+//a shared search stays alive as long as one of its requesters still waits for it
+static void SharedRequestSurvivesOneCancel() {
+    PathRequestService requests;
+    requests.Init(nullptr);
+
+    requests.Submit(1, { 0, 0 }, { 5, 5 }, 0);
+    requests.Submit(2, { 0, 0 }, { 5, 5 }, 0);
+    requests.Cancel(1);
+
+    size_t solves = 0;
+    std::vector<ecs::Entity> delivered;
+    requests.Process([&](glm::ivec2, glm::ivec2, PathResult&) { ++solves; }, false,
+        [](glm::ivec2, glm::ivec2, const std::shared_ptr<const PathResult>&) {},
+        [&](ecs::Entity entity, const PathResult&) { delivered.push_back(entity); });
+    assert(solves == 1 && requests.GetLastDropped() == 0);
+    assert(delivered.size() == 1 && delivered[0] == 2);
+}
+
+//a result nobody holds any more is handed back to the solver, empty but with its buffer, while a held one is not
+static void ReleasedResultsAreRecycled() {
+    PathRequestService requests;
+    requests.Init(nullptr);
+
+    std::vector<const PathResult*> solvedInto;
+    auto solve = [&](glm::ivec2 start, glm::ivec2 goal, PathResult& result) {
+        assert(result.path.empty() && result.coarsePath.empty() && result.pooledPath.Empty());
+        solvedInto.push_back(&result);
+        result.path.assign(64, glm::vec3(float(start.x), 0.0f, float(goal.x)));
+    };
+    std::shared_ptr<const PathResult> held;
+    auto deliver = [](ecs::Entity, const PathResult&) {};
+
+    requests.Submit(1, { 0, 0 }, { 5, 5 }, 0);
+    requests.Process(solve, false, [](glm::ivec2, glm::ivec2, const std::shared_ptr<const PathResult>&) {}, deliver);
+    requests.Submit(1, { 1, 1 }, { 6, 6 }, 0);
+    requests.Process(solve, false, [&](glm::ivec2, glm::ivec2, const std::shared_ptr<const PathResult>& result) { held = result; }, deliver);
+    assert(solvedInto.size() == 2 && solvedInto[1] == solvedInto[0]);
+    assert(held->path.capacity() >= 64);
+
+    requests.Submit(1, { 2, 2 }, { 7, 7 }, 0);
+    requests.Process(solve, false, [](glm::ivec2, glm::ivec2, const std::shared_ptr<const PathResult>&) {}, deliver);
+    assert(solvedInto.size() == 3 && solvedInto[2] != held.get());
+    assert(held->path.size() == 64 && held->path[0].z == 6.0f); //the cached answer is left alone
+}
+
+int main() {
+    DroppedRequestsDoNotSpendTheBudget();
+    SharedRequestSurvivesOneCancel();
+    ReleasedResultsAreRecycled();
+    std::printf("PathRequestService: all checks passed\n");
+    return 0;
+}